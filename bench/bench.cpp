@@ -0,0 +1,255 @@
+// Microbenchmarks of OSC'elot's OSC and mapping hot paths, built without Rack against bench/rack.hpp.
+// Results are written as JSON for regression tracking, see bench/Makefile.
+#include <rack.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <new>
+
+using namespace rack;
+
+#include "osc/OscSender.hpp"
+#include "osc/OscReceiver.hpp"
+#include "osc/OscController.hpp"
+#include "components/OscelotParam.hpp"
+
+using namespace TheModularMind;
+
+static std::atomic<uint64_t> allocations{0};
+
+void *operator new(std::size_t size) {
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	void *p = std::malloc(size ? size : 1);
+	if (!p) throw std::bad_alloc();
+	return p;
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+
+static const int NUM_SLOTS = 320;
+static const int REPETITIONS = 7;
+
+struct Result {
+	std::string name;
+	std::string unit;
+	uint64_t iterations;
+	double nsMedian;
+	double nsMin;
+	double allocsPerOp;
+};
+
+/**
+ * Calls fn(i) for the given number of iterations REPETITIONS times, reports median and best time
+ * per operation where every call performs opsPerCall operations.
+ */
+static Result measure(const std::string &name, const std::string &unit, uint64_t iterations, const std::function<void(uint64_t)> &fn, int opsPerCall = 1) {
+	// Warm up
+	for (uint64_t i = 0; i < iterations / 10 + 1; i++) fn(i);
+
+	std::vector<double> times;
+	uint64_t allocs = 0;
+	for (int r = 0; r < REPETITIONS; r++) {
+		uint64_t allocsStart = allocations.load(std::memory_order_relaxed);
+		auto start = std::chrono::steady_clock::now();
+		for (uint64_t i = 0; i < iterations; i++) fn(i);
+		auto end = std::chrono::steady_clock::now();
+		allocs += allocations.load(std::memory_order_relaxed) - allocsStart;
+		times.push_back(std::chrono::duration<double, std::nano>(end - start).count() / (iterations * opsPerCall));
+	}
+	std::sort(times.begin(), times.end());
+
+	Result result;
+	result.name = name;
+	result.unit = unit;
+	result.iterations = iterations * opsPerCall;
+	result.nsMedian = times[REPETITIONS / 2];
+	result.nsMin = times[0];
+	result.allocsPerOp = double(allocs) / (double(iterations) * opsPerCall * REPETITIONS);
+	std::fprintf(stderr, "%-28s %10.1f ns/%s (min %.1f) %8.2f allocs/%s\n", name.c_str(), result.nsMedian, unit.c_str(), result.nsMin, result.allocsPerOp, unit.c_str());
+	return result;
+}
+
+/** Exposes the listener entry point used by the socket thread */
+struct BenchReceiver : OscReceiver {
+	void receive(const char *data, int size, const IpEndpointName &endpoint) { ProcessPacket(data, size, endpoint); }
+};
+
+static const char *ADDRESSES[] = {"/fader", "/encoder", "/button"};
+
+static std::vector<char> encodeMessages(int count, int firstId) {
+	std::vector<char> buffer(65536);
+	osc::OutboundPacketStream stream(buffer.data(), buffer.size());
+	if (count > 1) stream << osc::BeginBundleImmediate;
+	for (int i = 0; i < count; i++) {
+		int id = (firstId + i) % NUM_SLOTS;
+		stream << osc::BeginMessage(ADDRESSES[id % 3]) << (osc::int32)id << 0.5f << osc::EndMessage;
+	}
+	if (count > 1) stream << osc::EndBundle;
+	buffer.resize(stream.Size());
+	return buffer;
+}
+
+int main(int argc, char **argv) {
+	double scale = 1.0;
+	int sendPort = 57999;
+	const char *outPath = nullptr;
+	for (int i = 1; i < argc; i++) {
+		if (!std::strcmp(argv[i], "--quick")) {
+			scale = 0.1;
+		} else if (!std::strcmp(argv[i], "--port") && i + 1 < argc) {
+			sendPort = std::atoi(argv[++i]);
+		} else if (!std::strcmp(argv[i], "--out") && i + 1 < argc) {
+			outPath = argv[++i];
+		} else {
+			std::fprintf(stderr, "Usage: %s [--quick] [--port <udp port>] [--out <file.json>]\n", argv[0]);
+			return 1;
+		}
+	}
+	auto n = [&](uint64_t iterations) { return std::max<uint64_t>(1, uint64_t(iterations * scale)); };
+
+	std::vector<Result> results;
+	IpEndpointName endpoint("127.0.0.1", 9000);
+
+	// Plain oscpack parsing of a single message
+	std::vector<char> single = encodeMessages(1, 7);
+	volatile float sink = 0.f;
+	results.push_back(measure("oscpack_parse", "message", n(2000000), [&](uint64_t) {
+		osc::ReceivedPacket packet(single.data(), (osc::osc_bundle_element_size_t)single.size());
+		osc::ReceivedMessage message(packet);
+		auto arg = message.ArgumentsBegin();
+		int id = (arg++)->AsInt32();
+		sink = sink + id + (arg++)->AsFloat();
+	}));
+
+	// Listener thread path: parse, convert to OscMessage, queue and dequeue on the engine side
+	BenchReceiver receiver;
+	OscStats stats;
+	receiver.stats = &stats;
+	OscMessage received;
+	results.push_back(measure("receiver_message", "message", n(500000), [&](uint64_t) {
+		receiver.receive(single.data(), single.size(), endpoint);
+		receiver.shift(&received);
+	}));
+
+	const int BUNDLE_SIZE = 32;
+	std::vector<char> bundle = encodeMessages(BUNDLE_SIZE, 0);
+	results.push_back(measure("receiver_bundle32", "message", n(20000), [&](uint64_t) {
+		receiver.receive(bundle.data(), bundle.size(), endpoint);
+		for (int i = 0; i < BUNDLE_SIZE; i++) receiver.shift(&received);
+	}, BUNDLE_SIZE));
+
+	// Routing of a message to its mapping slot as in OscelotModule::processOscMessage()
+	OscController controllers[NUM_SLOTS];
+	OscControllerState states[NUM_SLOTS];
+	for (int id = 0; id < NUM_SLOTS; id++) controllers[id].init(ADDRESSES[id % 3], id);
+	std::vector<OscMessage> messages(NUM_SLOTS);
+	for (int id = 0; id < NUM_SLOTS; id++) {
+		messages[id].setAddress(ADDRESSES[id % 3]);
+		messages[id].addIntArg(id);
+		messages[id].addFloatArg(0.5f);
+	}
+	uint32_t ts = 0;
+	results.push_back(measure("route_320", "message", n(200000), [&](uint64_t i) {
+		const OscMessage &msg = messages[(i * 37) % NUM_SLOTS];
+		std::string address = msg.getAddress();
+		int controllerId = msg.getArgAsInt(0);
+		float value = msg.getArgAsFloat(1);
+		ts++;
+		for (int id = 0; id < NUM_SLOTS; id++) {
+			if (controllers[id].matches(controllerId, address)) {
+				controllers[id].setCurrentValue(states[id], value, ts);
+				break;
+			}
+		}
+	}));
+
+	// Feedback of one slot: bundle construction, encoding and sending over loopback
+	OscSender sender;
+	std::string host = "127.0.0.1";
+	if (sender.start(host, sendPort)) {
+		sender.stats = &stats;
+		results.push_back(measure("sender_feedback", "message", n(200000), [&](uint64_t i) {
+			int id = i % NUM_SLOTS;
+			OscBundle feedbackBundle;
+			OscMessage valueMessage;
+			valueMessage.setAddress(controllers[id].getAddress());
+			valueMessage.addIntArg(controllers[id].getControllerId());
+			valueMessage.addFloatArg(states[id].getCurrentValue());
+			feedbackBundle.addMessage(valueMessage);
+			sender.sendFeedback(id, false, feedbackBundle);
+		}));
+	}
+
+	// Per-slot parameter update as in OscelotModule::process(), every 8th slot changes per tick
+	ParamQuantity paramQuantities[NUM_SLOTS];
+	OscelotParam params[NUM_SLOTS];
+	for (int id = 0; id < NUM_SLOTS; id++) {
+		params[id].setLimits(0.f, 1.f, -1.f);
+		params[id].setParamQuantity(&paramQuantities[id]);
+	}
+	results.push_back(measure("param_tick_320", "tick", n(100000), [&](uint64_t i) {
+		for (int id = 0; id < NUM_SLOTS; id++) {
+			if ((id + i) % 8 == 0) params[id].setValue((i % 100) * 0.01f);
+			if (params[id].process()) stats.latency.record(1000 + id);
+			sink = sink + params[id].getValue();
+		}
+	}));
+
+	// Controller state of all slots as in OscelotModule::process(): input mode, toggle state and the
+	// feedback check against the display value, every 8th slot receives a value per tick
+	const int NUM_DISPLAY_VALUES = 100;
+	std::string displayValues[NUM_DISPLAY_VALUES];
+	for (int v = 0; v < NUM_DISPLAY_VALUES; v++) displayValues[v] = std::to_string(v * 0.01f) + " V";
+	for (int id = 0; id < NUM_SLOTS; id++) {
+		controllers[id].init(ADDRESSES[id % 3], id, id % 5 == 3 ? CONTROLLERMODE::TOGGLE : CONTROLLERMODE::DIRECT);
+		controllers[id].serial = id + 1;
+	}
+	results.push_back(measure("controller_tick_320", "tick", n(100000), [&](uint64_t i) {
+		for (int id = 0; id < NUM_SLOTS; id++) {
+			const OscController &controller = controllers[id];
+			OscControllerState &state = states[id];
+			controller.updateState(state);
+			if ((id + i) % 8 == 0) controller.setCurrentValue(state, (i % 100) * 0.01f, i + 1);
+			float value = -1.f;
+			if (controller.getControllerMode() == CONTROLLERMODE::DIRECT) {
+				if (state.getValueIn() != state.getCurrentValue()) {
+					state.setValueIn(state.getCurrentValue());
+					value = state.getCurrentValue();
+				}
+			} else {
+				bool pressed = state.getCurrentValue() > 0.f;
+				bool released = state.getCurrentValue() == 0.f;
+				switch (state.toggleState) {
+					case TOGGLESTATE::IDLE: if (pressed) value = 1.f, state.toggleState = TOGGLESTATE::PRESSED_ON; break;
+					case TOGGLESTATE::PRESSED_ON: if (released) value = 1.f, state.toggleState = TOGGLESTATE::RELEASED_ON; break;
+					case TOGGLESTATE::RELEASED_ON: if (pressed) value = 0.f, state.toggleState = TOGGLESTATE::PRESSED_OFF; break;
+					case TOGGLESTATE::PRESSED_OFF: if (released) value = 0.f, state.toggleState = TOGGLESTATE::IDLE; break;
+				}
+			}
+			uint64_t valueOut = OscController::hashValue(displayValues[(i / 8 + id) % NUM_DISPLAY_VALUES]);
+			if (state.isValueOutChanged(valueOut)) {
+				state.setValueOut(valueOut);
+				sink = sink + value;
+			}
+		}
+	}));
+
+	results.push_back(measure("latency_record", "sample", n(5000000), [&](uint64_t i) { stats.latency.record(500 + i % 100000); }));
+
+	FILE *out = outPath ? std::fopen(outPath, "w") : stdout;
+	if (!out) {
+		std::fprintf(stderr, "Can't write to %s\n", outPath);
+		return 1;
+	}
+	std::fprintf(out, "{\n  \"benchmarks\": [\n");
+	for (size_t i = 0; i < results.size(); i++) {
+		const Result &r = results[i];
+		std::fprintf(out, "    {\"name\": \"%s\", \"unit\": \"%s\", \"iterations\": %llu, \"ns_median\": %.2f, \"ns_min\": %.2f, \"allocs\": %.3f}%s\n", r.name.c_str(), r.unit.c_str(),
+					 (unsigned long long)r.iterations, r.nsMedian, r.nsMin, r.allocsPerOp, i + 1 < results.size() ? "," : "");
+	}
+	std::fprintf(out, "  ]\n}\n");
+	if (outPath) std::fclose(out);
+	return 0;
+}
@@ -0,0 +1,305 @@
+// OSC load generator and soak test for OSC'elot over loopback, only depends on oscpack.
+// Sends fader sweeps, encoder bursts, bundles and malformed packets to OSC'elot's receive
+// port and verifies the feedback arriving on its send port.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "osc/LatencyHistogram.hpp"
+#include "osc/oscpack/ip/UdpSocket.h"
+#include "osc/oscpack/osc/OscOutboundPacketStream.h"
+#include "osc/oscpack/osc/OscPacketListener.h"
+
+using namespace TheModularMind;
+
+struct Options {
+	std::string host = "127.0.0.1";
+	int port = 7000;
+	int listenPort = 8881;
+	int faders = 8;
+	float rate = 100.f;
+	float duration = 10.f;
+	int encoders = 0;
+	int burst = 16;
+	float burstInterval = 0.25f;
+	int bundle = 1;
+	float malformed = 0.f;
+	float settle = 1.f;
+};
+
+/** Value of the malformed messages, never sent by the fader sweeps which stay below 1 */
+static const float MALFORMED_VALUE = 1.f;
+
+/** Values sent to one controller, remembered to match the feedback */
+struct ControllerState {
+	static const int HISTORY = 256;
+	float values[HISTORY];
+	int64_t times[HISTORY];
+	uint64_t sent = 0;
+	uint64_t feedback = 0;
+	uint64_t matched = 0;
+	float lastSent = -1.f;
+	float lastFeedback = -1.f;
+
+	void addSent(float value, int64_t time) {
+		values[sent % HISTORY] = value;
+		times[sent % HISTORY] = time;
+		lastSent = value;
+		sent++;
+	}
+
+	/** Returns the send time of the newest value matching the feedback, 0 if there is none */
+	int64_t findSent(float value) {
+		for (uint64_t i = 0; i < std::min<uint64_t>(sent, HISTORY); i++) {
+			uint64_t index = (sent - 1 - i) % HISTORY;
+			if (std::fabs(values[index] - value) < 1e-4f) return times[index];
+		}
+		return 0;
+	}
+};
+
+struct FeedbackVerifier : public osc::OscPacketListener {
+	std::mutex mutex;
+	std::map<std::pair<std::string, int>, ControllerState> controllers;
+	LatencyHistogram latency;
+	std::atomic<uint64_t> packets{0};
+	std::atomic<uint64_t> messages{0};
+	std::atomic<uint64_t> unknown{0};
+	/** Feedback showing that a malformed message changed a slot */
+	std::atomic<uint64_t> malformedApplied{0};
+
+	void addSent(const std::string &address, int id, float value, int64_t time) {
+		std::lock_guard<std::mutex> lock(mutex);
+		controllers[std::make_pair(address, id)].addSent(value, time);
+	}
+
+	virtual void ProcessPacket(const char *data, int size, const IpEndpointName &remoteEndpoint) override {
+		packets++;
+		try {
+			osc::OscPacketListener::ProcessPacket(data, size, remoteEndpoint);
+		} catch (osc::Exception &e) {
+			unknown++;
+		}
+	}
+
+   protected:
+	virtual void ProcessMessage(const osc::ReceivedMessage &message, const IpEndpointName &remoteEndpoint) override {
+		int64_t now = LatencyHistogram::now();
+		messages++;
+		auto arg = message.ArgumentsBegin();
+		if (message.ArgumentCount() < 2 || !arg->IsInt32()) {
+			unknown++;
+			return;
+		}
+		int id = (arg++)->AsInt32();
+		if (!arg->IsFloat()) {
+			unknown++;
+			return;
+		}
+		float value = arg->AsFloat();
+
+		std::lock_guard<std::mutex> lock(mutex);
+		auto it = controllers.find(std::make_pair(std::string(message.AddressPattern()), id));
+		if (it == controllers.end()) {
+			unknown++;
+			return;
+		}
+		ControllerState &state = it->second;
+		if (std::fabs(value - MALFORMED_VALUE) < 1e-4f) malformedApplied++;
+		state.feedback++;
+		state.lastFeedback = value;
+		int64_t sentTime = state.findSent(value);
+		if (sentTime > 0) {
+			state.matched++;
+			latency.record(now - sentTime);
+		}
+	}
+};
+
+static void printUsage(const char *name) {
+	std::fprintf(stderr,
+				 "Usage: %s [options]\n"
+				 "  --host <host>          OSC'elot host (127.0.0.1)\n"
+				 "  --port <port>          OSC'elot receive port (7000)\n"
+				 "  --listen <port>        port receiving OSC'elot's feedback (8881), 0 disables the verifier\n"
+				 "  --faders <n>           number of faders /fader 0..n-1 (8)\n"
+				 "  --rate <hz>            updates per fader and second (100)\n"
+				 "  --duration <s>         test duration (10)\n"
+				 "  --encoders <n>         number of encoders /encoder 0..n-1 (0)\n"
+				 "  --burst <n>            encoder messages per burst (16)\n"
+				 "  --burst-interval <s>   time between encoder bursts (0.25)\n"
+				 "  --bundle <n>           messages per packet, > 1 sends bundles (1)\n"
+				 "  --malformed <ratio>    ratio of malformed packets, 0..1 (0)\n"
+				 "  --settle <s>           time to wait for feedback after sending (1)\n",
+				 name);
+}
+
+static bool parseOptions(int argc, char **argv, Options &o) {
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (i + 1 >= argc) return false;
+		const char *value = argv[++i];
+		if (arg == "--host") o.host = value;
+		else if (arg == "--port") o.port = std::atoi(value);
+		else if (arg == "--listen") o.listenPort = std::atoi(value);
+		else if (arg == "--faders") o.faders = std::atoi(value);
+		else if (arg == "--rate") o.rate = std::atof(value);
+		else if (arg == "--duration") o.duration = std::atof(value);
+		else if (arg == "--encoders") o.encoders = std::atoi(value);
+		else if (arg == "--burst") o.burst = std::atoi(value);
+		else if (arg == "--burst-interval") o.burstInterval = std::atof(value);
+		else if (arg == "--bundle") o.bundle = std::max(1, std::atoi(value));
+		else if (arg == "--malformed") o.malformed = std::atof(value);
+		else if (arg == "--settle") o.settle = std::atof(value);
+		else return false;
+	}
+	return o.rate > 0.f && o.faders >= 0 && o.encoders >= 0;
+}
+
+/** Sends a packet which OSC'elot has to reject without side effects */
+static void sendMalformed(UdpTransmitSocket &socket, uint64_t seq) {
+	char buffer[64];
+	osc::OutboundPacketStream stream(buffer, sizeof(buffer));
+	switch (seq % 3) {
+		case 0: {
+			// Truncated message
+			stream << osc::BeginMessage("/fader") << (osc::int32)0 << 0.5f << osc::EndMessage;
+			socket.Send(stream.Data(), stream.Size() - 3);
+		} break;
+		case 1: {
+			// Missing address pattern
+			const char garbage[] = {'f', 'a', 'd', 'e', 'r', 0, 0, 0, ',', 'i', 'f', 0};
+			socket.Send(garbage, sizeof(garbage));
+		} break;
+		case 2: {
+			// Wrong argument types, a slot set to MALFORMED_VALUE shows up in the feedback
+			stream << osc::BeginMessage("/fader") << "zero" << (osc::int32)MALFORMED_VALUE << osc::EndMessage;
+			socket.Send(stream.Data(), stream.Size());
+		} break;
+	}
+}
+
+int main(int argc, char **argv) {
+	Options o;
+	if (!parseOptions(argc, argv, o)) {
+		printUsage(argv[0]);
+		return 1;
+	}
+
+	FeedbackVerifier verifier;
+	std::unique_ptr<UdpListeningReceiveSocket> listenSocket;
+	std::thread listenThread;
+	if (o.listenPort > 0) {
+		listenSocket.reset(new UdpListeningReceiveSocket(IpEndpointName(IpEndpointName::ANY_ADDRESS, o.listenPort), &verifier));
+		listenThread = std::thread([&] { listenSocket->Run(); });
+	}
+	UdpTransmitSocket socket(IpEndpointName(o.host.c_str(), o.port));
+
+	std::vector<char> buffer(65536);
+	uint64_t messagesSent = 0, packetsSent = 0, malformedSent = 0, sendErrors = 0;
+	uint64_t tick = 0;
+	float malformedDebt = 0.f;
+	double nextBurst = 0.0;
+	std::vector<float> encoderDirections(o.encoders, 1.f);
+
+	std::fprintf(stderr, "Sending %d faders at %.0f Hz, %d encoders to %s:%d for %.0f s\n", o.faders, o.rate, o.encoders, o.host.c_str(), o.port, o.duration);
+	auto start = std::chrono::steady_clock::now();
+	auto tickDuration = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / o.rate));
+	auto next = start;
+	double elapsed = 0.0;
+
+	while ((elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()) < o.duration) {
+		osc::OutboundPacketStream stream(buffer.data(), buffer.size());
+		int inPacket = 0;
+		auto flush = [&]() {
+			if (inPacket == 0) return;
+			if (o.bundle > 1) stream << osc::EndBundle;
+			try {
+				socket.Send(stream.Data(), stream.Size());
+				packetsSent++;
+			} catch (std::exception &e) {
+				sendErrors++;
+			}
+			stream.Clear();
+			inPacket = 0;
+		};
+		auto add = [&](const char *address, int id, float value) {
+			if (inPacket == 0 && o.bundle > 1) stream << osc::BeginBundleImmediate;
+			stream << osc::BeginMessage(address) << (osc::int32)id << value << osc::EndMessage;
+			messagesSent++;
+			if (++inPacket >= o.bundle) flush();
+		};
+
+		// Every fader ramps with its own phase, values repeat after 1000 ticks only
+		int64_t now = LatencyHistogram::now();
+		for (int i = 0; i < o.faders; i++) {
+			float value = float((tick + i * 1000 / std::max(1, o.faders)) % 1000) / 1000.f;
+			if (o.listenPort > 0) verifier.addSent("/fader", i, value, now);
+			add("/fader", i, value);
+		}
+		if (o.encoders > 0 && elapsed >= nextBurst) {
+			for (int b = 0; b < o.burst; b++) {
+				int id = b % o.encoders;
+				add("/encoder", id, encoderDirections[id]);
+			}
+			for (float &direction : encoderDirections) direction = -direction;
+			nextBurst += o.burstInterval;
+		}
+		flush();
+
+		malformedDebt += o.malformed * o.faders / std::max(1, o.bundle);
+		while (malformedDebt >= 1.f) {
+			try {
+				sendMalformed(socket, malformedSent++);
+			} catch (std::exception &e) {
+				sendErrors++;
+			}
+			malformedDebt -= 1.f;
+		}
+
+		tick++;
+		next += tickDuration;
+		std::this_thread::sleep_until(next);
+	}
+	elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::printf("sent:      %llu messages in %llu packets, %.0f msg/s (target %.0f), %llu malformed, %llu errors\n", (unsigned long long)messagesSent, (unsigned long long)packetsSent,
+				messagesSent / elapsed, o.rate * (o.faders + (o.encoders > 0 ? o.burst / (o.rate * o.burstInterval) : 0.f)), (unsigned long long)malformedSent, (unsigned long long)sendErrors);
+
+	if (o.listenPort > 0) {
+		std::this_thread::sleep_for(std::chrono::duration<double>(o.settle));
+		listenSocket->AsynchronousBreak();
+		listenThread.join();
+
+		std::lock_guard<std::mutex> lock(verifier.mutex);
+		uint64_t sent = 0, feedback = 0, matched = 0;
+		int converged = 0, faders = 0;
+		for (auto &it : verifier.controllers) {
+			ControllerState &state = it.second;
+			sent += state.sent;
+			feedback += state.feedback;
+			matched += state.matched;
+			faders++;
+			if (std::fabs(state.lastFeedback - state.lastSent) < 1e-4f) converged++;
+		}
+		std::printf("feedback:  %llu packets, %llu messages, %.0f msg/s, %llu unmatched\n", (unsigned long long)verifier.packets, (unsigned long long)verifier.messages,
+					verifier.messages / elapsed, (unsigned long long)verifier.unknown);
+		std::printf("faders:    %llu of %llu values echoed (%.1f%% not seen), %d of %d faders converged to the last value\n", (unsigned long long)matched, (unsigned long long)sent,
+					sent > 0 ? 100.0 * (sent - matched) / sent : 0.0, converged, faders);
+		std::printf("latency:   p50 %.0f us, p99 %.0f us, max %.0f us\n", verifier.latency.getPercentile(0.5f) / 1000.0, verifier.latency.getPercentile(0.99f) / 1000.0,
+					verifier.latency.max / 1000.0);
+		std::printf("malformed: %llu slots changed by malformed messages\n", (unsigned long long)verifier.malformedApplied);
+		return converged == faders && verifier.malformedApplied == 0 ? 0 : 2;
+	}
+	return 0;
+}
@@ -0,0 +1,51 @@
+// Minimal stand-in for the parts of the VCV Rack SDK used by the OSC core, so the
+// benchmarks can be built and run without Rack.
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define DEBUG(format, ...) ((void)0)
+#define INFO(format, ...) ((void)0)
+#define WARN(format, ...) ((void)0)
+#define FATAL(format, ...) rack::logFatal(format, ##__VA_ARGS__)
+
+namespace rack {
+
+inline void logFatal(const char *format, ...) {
+	va_list args;
+	va_start(args, format);
+	std::vfprintf(stderr, format, args);
+	std::fputc('\n', stderr);
+	va_end(args);
+}
+
+}  // namespace rack
+
+namespace rack {
+namespace math {
+
+inline float clamp(float x, float a, float b) { return std::fmax(std::fmin(x, b), a); }
+inline float rescale(float x, float xMin, float xMax, float yMin, float yMax) { return yMin + (x - xMin) / (xMax - xMin) * (yMax - yMin); }
+
+}  // namespace math
+
+using namespace math;
+
+struct ParamQuantity {
+	float value = 0.f;
+	float getScaledValue() { return value; }
+	void setScaledValue(float value) { this->value = value; }
+};
+
+}  // namespace rack
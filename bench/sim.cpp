@@ -0,0 +1,371 @@
+// Headless simulation of OscelotModule::process without Rack's window and audio thread.
+// Mock modules provide the mapped parameters, OSC input is generated, read from a text
+// script or replayed from a recording and fed into the module's receiver at sample
+// accurate positions. Build with "make sim", see --help for the options.
+//
+// The module is only visible inside its translation unit, therefore Oscelot.cpp is
+// included here and its object is left out when linking the other plugin objects.
+#include "../src/Oscelot.cpp"
+
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <thread>
+
+using namespace TheModularMind;
+using namespace TheModularMind::Oscelot;
+
+struct SimOptions {
+	int slots = 320;
+	int modules = 0;
+	int params = 32;
+	CONTROLLERMODE mode = CONTROLLERMODE::DIRECT;
+	std::string address = "/fader";
+	bool encoder = false;
+	float seconds = 60.f;
+	float sampleRate = 48000.f;
+	float rate = 1000.f;
+	int banks = 1;
+	float bankInterval = 1.f;
+	int division = 512;
+	int feedbackPort = 57998;
+	std::string script;
+	std::string replay;
+	std::string out;
+};
+
+/** Module with a configurable number of parameters in the range 0..1, nothing to process */
+struct SimModule : Module {
+	static int numParams;
+	SimModule() {
+		config(numParams, 0, 0, 0);
+		for (int i = 0; i < numParams; i++) configParam(i, 0.f, 1.f, 0.5f, string::f("Param %d", i));
+	}
+};
+int SimModule::numParams = 32;
+
+struct SimModuleWidget : ModuleWidget {
+	SimModuleWidget(SimModule* module) { setModule(module); }
+};
+
+/** A packet to be received at the given sample */
+struct SimEvent {
+	uint64_t frame;
+	std::vector<char> data;
+	IpEndpointName endpoint;
+};
+
+void init(rack::Plugin* p);
+
+/** Sleeps until ready() holds, like a patch left running between user actions, false after timeout seconds */
+static bool waitFor(OscelotModule* oscelot, std::function<bool()> ready, double timeout) {
+	double start = system::getTime();
+	while (!ready()) {
+		if (system::getTime() - start > timeout) return false;
+		// Between calls of process() the engine holds no table, so the stager can reclaim them
+		oscelot->mappingTables.quiescent(MappingTables::READER_ENGINE);
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	return true;
+}
+
+static std::vector<char> encodeMessage(const std::string& address, int controllerId, float value) {
+	char buffer[256];
+	osc::OutboundPacketStream stream(buffer, sizeof(buffer));
+	stream << osc::BeginMessage(address.c_str()) << (osc::int32)controllerId << value << osc::EndMessage;
+	return std::vector<char>(stream.Data(), stream.Data() + stream.Size());
+}
+
+/** Every event moves the next slot: ramps for faders, alternating presses for buttons, steps for encoders */
+static void generateEvents(const SimOptions& o, std::vector<SimEvent>& events) {
+	uint64_t count = uint64_t(o.seconds * o.rate);
+	IpEndpointName endpoint("127.0.0.1", 9000);
+	for (uint64_t k = 0; k < count; k++) {
+		int slot = k % o.slots;
+		uint64_t round = k / o.slots;
+		float value;
+		if (o.encoder) {
+			value = (round / 50) % 2 ? -10.f : 10.f;
+		} else if (o.mode == CONTROLLERMODE::TOGGLE || o.mode == CONTROLLERMODE::TOGGLE_VALUE) {
+			value = round % 2 ? 0.f : 1.f;
+		} else {
+			value = float(round % 100) / 100.f;
+		}
+		events.push_back({uint64_t(k / o.rate * o.sampleRate), encodeMessage(o.address, slot, value), endpoint});
+	}
+}
+
+/** Text script, one message per line: <time in seconds> <address> <controller id> <value> */
+static bool loadScript(const SimOptions& o, std::vector<SimEvent>& events) {
+	std::ifstream file(o.script);
+	if (!file) return false;
+	IpEndpointName endpoint("127.0.0.1", 9000);
+	std::string line;
+	while (std::getline(file, line)) {
+		if (line.empty() || line[0] == '#') continue;
+		std::istringstream fields(line);
+		double time;
+		std::string address;
+		int controllerId;
+		float value;
+		if (!(fields >> time >> address >> controllerId >> value)) continue;
+		events.push_back({uint64_t(time * o.sampleRate), encodeMessage(address, controllerId, value), endpoint});
+	}
+	std::stable_sort(events.begin(), events.end(), [](const SimEvent& a, const SimEvent& b) { return a.frame < b.frame; });
+	return true;
+}
+
+static bool loadRecording(const SimOptions& o, std::vector<SimEvent>& events) {
+	OscPacketLogReader reader;
+	if (!reader.open(o.replay)) return false;
+	SimEvent event;
+	uint64_t time;
+	while (reader.next(time, event.endpoint, event.data)) {
+		event.frame = uint64_t(time * 1e-9 * o.sampleRate);
+		events.push_back(event);
+	}
+	return true;
+}
+
+static bool parseMode(const std::string& name, SimOptions& o) {
+	if (name == "direct") o.mode = CONTROLLERMODE::DIRECT;
+	else if (name == "pickup1") o.mode = CONTROLLERMODE::PICKUP1;
+	else if (name == "pickup2") o.mode = CONTROLLERMODE::PICKUP2;
+	else if (name == "toggle") o.mode = CONTROLLERMODE::TOGGLE;
+	else if (name == "toggle_value") o.mode = CONTROLLERMODE::TOGGLE_VALUE;
+	else if (name == "encoder") o.encoder = true;
+	else return false;
+	o.address = o.encoder ? "/encoder" : (o.mode == CONTROLLERMODE::TOGGLE || o.mode == CONTROLLERMODE::TOGGLE_VALUE) ? "/button" : "/fader";
+	return true;
+}
+
+static void printUsage(const char* name) {
+	std::fprintf(stderr,
+				 "Usage: %s [options]\n"
+				 "  --slots <n>            mapped slots per bank (320)\n"
+				 "  --params <n>           parameters per mock module (32)\n"
+				 "  --modules <n>          mock modules, default enough for all banks\n"
+				 "  --mode <mode>          direct, pickup1, pickup2, toggle, toggle_value or encoder (direct)\n"
+				 "  --seconds <s>          simulated time (60)\n"
+				 "  --sample-rate <hz>     (48000)\n"
+				 "  --rate <hz>            generated OSC messages per second (1000)\n"
+				 "  --banks <n>            banks, switched every --bank-interval seconds (1)\n"
+				 "  --bank-interval <s>    (1)\n"
+				 "  --division <n>         process division of the module (512)\n"
+				 "  --feedback-port <port> send feedback to 127.0.0.1:<port>, 0 disables feedback (57998)\n"
+				 "  --script <file>        OSC input from a text script instead of generated traffic\n"
+				 "  --replay <file>        OSC input from a recording instead of generated traffic\n"
+				 "  --out <file>           write the JSON report to a file instead of stdout\n",
+				 name);
+}
+
+static bool parseOptions(int argc, char** argv, SimOptions& o) {
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (i + 1 >= argc) return false;
+		std::string value = argv[++i];
+		if (arg == "--slots") o.slots = std::max(1, std::stoi(value));
+		else if (arg == "--params") o.params = std::max(1, std::stoi(value));
+		else if (arg == "--modules") o.modules = std::stoi(value);
+		else if (arg == "--mode") {
+			if (!parseMode(value, o)) return false;
+		}
+		else if (arg == "--seconds") o.seconds = std::stof(value);
+		else if (arg == "--sample-rate") o.sampleRate = std::stof(value);
+		else if (arg == "--rate") o.rate = std::stof(value);
+		else if (arg == "--banks") o.banks = clamp(std::stoi(value), 1, 128);
+		else if (arg == "--bank-interval") o.bankInterval = std::stof(value);
+		else if (arg == "--division") o.division = std::max(1, std::stoi(value));
+		else if (arg == "--feedback-port") o.feedbackPort = std::stoi(value);
+		else if (arg == "--script") o.script = value;
+		else if (arg == "--replay") o.replay = value;
+		else if (arg == "--out") o.out = value;
+		else return false;
+	}
+	return true;
+}
+
+int main(int argc, char** argv) {
+	SimOptions o;
+	if (!parseOptions(argc, argv, o)) {
+		printUsage(argv[0]);
+		return 1;
+	}
+	if (o.modules <= 0) o.modules = (o.slots * o.banks + o.params - 1) / o.params;
+	SimModule::numParams = o.params;
+
+	// Minimal headless Rack: no window, no audio, the engine is only used for its modules and param handles
+	rack::settings::devMode = true;
+	rack::random::init();
+	rack::asset::init();
+	rack::logger::init();
+	rack::contextSet(new rack::Context);
+	APP->engine = new engine::Engine;
+	APP->engine->setSampleRate(o.sampleRate);
+
+	Plugin* plugin = new Plugin;
+	plugin->slug = "TheModularMind";
+	init(plugin);
+	Model* modelSim = createModel<SimModule, SimModuleWidget>("OscelotSim");
+	plugin->addModel(modelSim);
+
+	std::vector<Module*> modules;
+	for (int i = 0; i < o.modules; i++) {
+		Module* m = modelSim->createModule();
+		APP->engine->addModule(m);
+		modules.push_back(m);
+	}
+	OscelotModule* oscelot = dynamic_cast<OscelotModule*>(modelOSCelot->createModule());
+	APP->engine->addModule(oscelot);
+
+	// Configure the mappings of all banks the same way a saved patch would
+	json_t* rootJ = oscelot->dataToJson();
+	json_object_set_new(rootJ, "processDivision", json_integer(o.division));
+	json_object_set_new(rootJ, "sending", json_boolean(o.feedbackPort > 0));
+	json_object_set_new(rootJ, "ip", json_string("127.0.0.1"));
+	json_object_set_new(rootJ, "txPort", json_string(std::to_string(o.feedbackPort).c_str()));
+	json_t* banksJ = json_array();
+	int totalParams = o.modules * o.params;
+	for (int bank = 0; bank < o.banks; bank++) {
+		json_t* paramsJ = json_array();
+		for (int slot = 0; slot < o.slots; slot++) {
+			int param = (bank * o.slots + slot) % totalParams;
+			json_t* paramJ = json_object();
+			json_object_set_new(paramJ, "moduleId", json_integer(modules[param / o.params]->id));
+			json_object_set_new(paramJ, "paramId", json_integer(param % o.params));
+			json_object_set_new(paramJ, "controllerId", json_integer(slot));
+			json_object_set_new(paramJ, "controllerMode", json_integer((int)o.mode));
+			json_object_set_new(paramJ, "address", json_string(o.address.c_str()));
+			json_array_append_new(paramsJ, paramJ);
+		}
+		json_t* bankJ = json_object();
+		json_object_set_new(bankJ, "bankIndex", json_integer(bank));
+		json_object_set_new(bankJ, "params", paramsJ);
+		json_array_append_new(banksJ, bankJ);
+	}
+	json_object_set_new(rootJ, "banks", banksJ);
+	json_object_set_new(rootJ, "currentBankIndex", json_integer(0));
+	oscelot->dataFromJson(rootJ);
+	json_decref(rootJ);
+	oscelot->setProcessDivision(o.division);
+	// The stager thread adds the slots and maps what didn't fit
+	if (!waitFor(oscelot, [&]() { return !oscelot->reapplyMappings; }, 10.0)) {
+		std::fprintf(stderr, "Slots weren't added in time\n");
+		return 1;
+	}
+
+	std::vector<SimEvent> events;
+	if (!o.replay.empty()) {
+		if (!loadRecording(o, events)) return 1;
+	} else if (!o.script.empty()) {
+		if (!loadScript(o, events)) {
+			std::fprintf(stderr, "Can't read script %s\n", o.script.c_str());
+			return 1;
+		}
+	} else {
+		generateEvents(o, events);
+	}
+
+	// Run
+	uint64_t frames = uint64_t(o.seconds * o.sampleRate);
+	uint64_t bankFrames = std::max<uint64_t>(1, uint64_t(o.bankInterval * o.sampleRate));
+	Module::ProcessArgs args;
+	args.sampleRate = o.sampleRate;
+	args.sampleTime = 1.f / o.sampleRate;
+	size_t nextEvent = 0;
+	double injectTime = 0.0;
+	double waitTime = 0.0;
+	std::vector<double> bankSwitchTimes;
+	int bankSwitchTimeouts = 0;
+	int bank = 0;
+	bool switching = false;
+	double switchStart = 0.0;
+	double switchInjectTime = 0.0;
+
+	double start = system::getTime();
+	for (uint64_t frame = 0; frame < frames; frame++) {
+		if (nextEvent < events.size() && events[nextEvent].frame <= frame) {
+			double t = system::getTime();
+			while (nextEvent < events.size() && events[nextEvent].frame <= frame) {
+				SimEvent& event = events[nextEvent++];
+				oscelot->oscReceiver.ProcessPacket(event.data.data(), event.data.size(), event.endpoint);
+			}
+			injectTime += system::getTime() - t;
+		}
+		args.frame = frame;
+		if (o.banks > 1 && frame > 0 && frame % bankFrames == 0) {
+			if (switching) bankSwitchTimeouts++;
+			bank = (bank + 1) % o.banks;
+			// Switched to once the stager has prepared the bank and the spare table, the wait isn't timed
+			double t = system::getTime();
+			auto staged = [&]() {
+				MappingTables& tables = oscelot->mappingTables;
+				return oscelot->bankStager.isStaged(bank, tables.getCapacity()) && tables.hasSpare() && tables.available() >= tables.getCapacity();
+			};
+			if (!waitFor(oscelot, staged, 10.0)) std::fprintf(stderr, "Bank %d wasn't staged in time\n", bank + 1);
+			waitTime += system::getTime() - t;
+			oscelot->params[OscelotModule::PARAM_BANK].setValue(bank);
+			switching = true;
+			switchStart = system::getTime();
+			switchInjectTime = injectTime;
+		}
+		oscelot->process(args);
+		// Might take several samples if the write mutex is held by the stager thread
+		if (switching && oscelot->currentBankIndex == bank) {
+			bankSwitchTimes.push_back(system::getTime() - switchStart - (injectTime - switchInjectTime));
+			switching = false;
+		}
+	}
+	if (switching) bankSwitchTimeouts++;
+	double elapsed = system::getTime() - start - injectTime - waitTime;
+
+	// Report
+	json_t* reportJ = json_object();
+	json_object_set_new(reportJ, "slots", json_integer(o.slots));
+	json_object_set_new(reportJ, "banks", json_integer(o.banks));
+	json_object_set_new(reportJ, "frames", json_integer(frames));
+	json_object_set_new(reportJ, "oscPackets", json_integer(events.size()));
+	json_object_set_new(reportJ, "nsPerSample", json_real(elapsed * 1e9 / frames));
+	json_object_set_new(reportJ, "realtimeFactor", json_real(o.seconds / elapsed));
+	json_object_set_new(reportJ, "tickTimeAvgUs", json_real(oscelot->stats.tickTimeAvg));
+	json_object_set_new(reportJ, "tickTimeMaxUs", json_real(oscelot->stats.tickTimeMax));
+	json_object_set_new(reportJ, "feedbackPackets", json_integer(oscelot->stats.packetsOut));
+	json_object_set_new(reportJ, "feedbackBytes", json_integer(oscelot->stats.bytesOut));
+	json_object_set_new(reportJ, "unknownAddresses", json_integer(oscelot->stats.unknownAddresses));
+	if (!bankSwitchTimes.empty()) {
+		double sum = 0.0, max = 0.0;
+		for (double t : bankSwitchTimes) {
+			sum += t;
+			max = std::max(max, t);
+		}
+		json_object_set_new(reportJ, "bankSwitches", json_integer(bankSwitchTimes.size()));
+		json_object_set_new(reportJ, "bankSwitchAvgUs", json_real(sum / bankSwitchTimes.size() * 1e6));
+		json_object_set_new(reportJ, "bankSwitchMaxUs", json_real(max * 1e6));
+	}
+	if (bankSwitchTimeouts > 0) json_object_set_new(reportJ, "bankSwitchTimeouts", json_integer(bankSwitchTimeouts));
+	json_t* statesJ = json_array();
+	for (int id = 0; id < oscelot->getMapLen(); id++) {
+		ParamHandle& paramHandle = oscelot->slots[id].paramHandle;
+		if (!paramHandle.module) continue;
+		json_t* stateJ = json_object();
+		json_object_set_new(stateJ, "slot", json_integer(id));
+		json_object_set_new(stateJ, "moduleId", json_integer(paramHandle.moduleId));
+		json_object_set_new(stateJ, "paramId", json_integer(paramHandle.paramId));
+		json_object_set_new(stateJ, "value", json_real(paramHandle.module->params[paramHandle.paramId].getValue()));
+		json_array_append_new(statesJ, stateJ);
+	}
+	json_object_set_new(reportJ, "params", statesJ);
+
+	FILE* out = o.out.empty() ? stdout : std::fopen(o.out.c_str(), "w");
+	if (out) {
+		json_dumpf(reportJ, out, JSON_INDENT(2));
+		std::fputc('\n', out);
+		if (out != stdout) std::fclose(out);
+	}
+	json_decref(reportJ);
+	std::fprintf(stderr, "%.1f ns/sample, %.0fx realtime, %llu feedback packets\n", elapsed * 1e9 / frames, o.seconds / elapsed, (unsigned long long)oscelot->stats.packetsOut);
+
+	APP->engine->clear();
+	return 0;
+}
@@ -8,20 +8,86 @@ namespace TheModularMind {
 
 // Widgets
 
-template< int MAX_PARAMS, typename MODULE >
+/** Renders its children into a framebuffer drawn on the light layer, so cached text stays lit in dark rooms */
+struct LightLayerFramebufferWidget : FramebufferWidget {
+	void draw(const DrawArgs& args) override {}
+
+	void drawLayer(const DrawArgs& args, int layer) override {
+		if (layer != 1) return;
+		nvgScissor(args.vg, RECT_ARGS(args.clipBox));
+		FramebufferWidget::draw(args);
+		nvgResetScissor(args.vg);
+	}
+};
+
+/** Background and text of a choice, drawn into the framebuffer of the choice */
+struct MapModuleChoiceText : Widget {
+	LedDisplayChoice* choice;
+
+	void draw(const DrawArgs& args) override {
+		if (choice->bgColor.a > 0.0) {
+			nvgScissor(args.vg, RECT_ARGS(args.clipBox));
+			nvgBeginPath(args.vg);
+			nvgRect(args.vg, 0, 0, box.size.x, box.size.y);
+			nvgFillColor(args.vg, choice->bgColor);
+			nvgFill(args.vg);
+			nvgResetScissor(args.vg);
+		}
+
+		std::shared_ptr<window::Font> font = APP->window->loadFont(choice->fontPath);
+
+		if (font && font->handle >= 0) {
+			Rect r = Rect(choice->textOffset.x, 0.f, box.size.x - choice->textOffset.x * 2, box.size.y).intersect(args.clipBox);
+			nvgScissor(args.vg, RECT_ARGS(r));
+			nvgFillColor(args.vg, choice->color);
+			nvgFontFaceId(args.vg, font->handle);
+			nvgTextLetterSpacing(args.vg, 0.0);
+			nvgFontSize(args.vg, 14);
+			nvgText(args.vg, choice->textOffset.x, choice->textOffset.y, choice->text.c_str(), NULL);
+			nvgResetScissor(args.vg);
+		}
+	}
+};
+
+template< typename MODULE >
 struct MapModuleChoice : LedDisplayChoice {
 	MODULE* module = NULL;
 	bool processEvents = true;
-	int id;
+	/** Slot shown by the row, -1 while the row isn't used */
+	int id = -1;
 
 	std::chrono::time_point<std::chrono::system_clock> hscrollUpdate = std::chrono::system_clock::now();
 	int hscrollCharOffset = 0;
 
+	// Text of the slot, built again only when something it depends on has changed
+	bool textValid = false;
+	int64_t textModuleId;
+	int textParamId;
+	bool textLearning;
+	uint64_t textVersion;
+	std::string textLabel;
+	std::string textPrefix;
+	std::string textName;
+	int textScrollOffset = -1;
+
+	/** The row is only rendered again when what it shows has changed */
+	LightLayerFramebufferWidget* fb;
+	MapModuleChoiceText* fbText;
+	std::string drawnText;
+	NVGcolor drawnColor;
+	NVGcolor drawnBgColor;
+
 	MapModuleChoice() {
 		box.size = mm2px(Vec(0, 7.5));
 		textOffset = Vec(6, 14.7);
 		fontPath = asset::plugin(pluginInstance, "res/fonts/NovaMono-Regular.ttf");
 		color = nvgRGB(0xf0, 0xf0, 0xf0);
+
+		fb = new LightLayerFramebufferWidget;
+		addChild(fb);
+		fbText = new MapModuleChoiceText;
+		fbText->choice = this;
+		fb->addChild(fbText);
 	}
 
 	~MapModuleChoice() {
@@ -34,9 +100,17 @@ struct MapModuleChoice : LedDisplayChoice {
 		this->module = module;
 	}
 
+	/** Rows are recycled for other slots while scrolling */
+	void setId(int id) {
+		if (this->id == id) return;
+		this->id = id;
+		textValid = false;
+		hscrollCharOffset = 0;
+	}
+
 	void onButton(const event::Button& e) override {
 		e.stopPropagating();
-		if (!module) return;
+		if (!module || id < 0) return;
 		if (module->locked) return;
 
 		if (e.action == GLFW_PRESS && e.button == GLFW_MOUSE_BUTTON_LEFT) {
@@ -46,7 +120,7 @@ struct MapModuleChoice : LedDisplayChoice {
 		if (e.action == GLFW_PRESS && e.button == GLFW_MOUSE_BUTTON_RIGHT) {
 			e.consume(this);
 
-			if (module->paramHandles[id].moduleId >= 0) {
+			if (module->slots[id].paramHandle.moduleId >= 0) {
 				createContextMenu();
 			} 
 			else {
@@ -71,7 +145,7 @@ struct MapModuleChoice : LedDisplayChoice {
 				int id;
 				void onSelectKey(const event::SelectKey& e) override {
 					if (e.action == GLFW_PRESS && e.key == GLFW_KEY_ENTER) {
-						module->textLabels[id] = text;
+						module->slots[id].textLabel = text;
 
 						ui::MenuOverlay* overlay = getAncestorOfType<ui::MenuOverlay>();
 						overlay->requestDelete();
@@ -92,12 +166,12 @@ struct MapModuleChoice : LedDisplayChoice {
 				labelField->box.size.x = 220;
 				labelField->module = module;
 				labelField->id = id;
-				labelField->text = module->textLabels[id];
+				labelField->text = module->slots[id].textLabel;
 				if(labelField->text==""){
 					labelField->text=tempLabel;
 				}
 				menu->addChild(labelField);
-				menu->addChild(createMenuItem("Reset", "", [=]() { module->textLabels[id] = ""; }));
+				menu->addChild(createMenuItem("Reset", "", [=]() { module->slots[id].textLabel = ""; }));
 
 				return menu;
 			}
@@ -111,9 +185,9 @@ struct MapModuleChoice : LedDisplayChoice {
 		    &LabelMenuItem::tempLabel, getSlotPrefix() == ".... " ? getParamName() : getSlotPrefix() + getParamName()));
 
 		menu->addChild(createMenuItem("Locate and indicate", "", [=]() {
-			ParamHandle* paramHandle = &module->paramHandles[id];
+			ParamHandle* paramHandle = &module->slots[id].paramHandle;
 			ModuleWidget* mw = APP->scene->rack->getModule(paramHandle->moduleId);
-			module->paramHandleIndicator[id].indicate(mw);
+			module->slots[id].indicator.indicate(mw);
 		}));
 
 		menu->addChild(new MenuSeparator());
@@ -124,7 +198,7 @@ struct MapModuleChoice : LedDisplayChoice {
 	virtual void appendContextMenu(Menu* menu) { }
 
 	void onSelect(const event::Select& e) override {
-		if (!module) return;
+		if (!module || id < 0) return;
 		if (module->locked) return;
 
 		ScrollWidget *scroll = getAncestorOfType<ScrollWidget>();
@@ -141,6 +215,11 @@ struct MapModuleChoice : LedDisplayChoice {
 	void onDeselect(const event::Deselect& e) override {
 		if (!module) return;
 		if (!processEvents) return;
+		if (id < 0) {
+			// Recycled after the slot had been scrolled out of view
+			glfwSetCursor(APP->window->win, NULL);
+			return;
+		}
 
 		// Check if a ParamWidget was touched, unstable API
 		ParamWidget *touchedParam = APP->scene->rack->touchedParam;
@@ -158,7 +237,7 @@ struct MapModuleChoice : LedDisplayChoice {
 	}
 
 	void step() override {
-		if (!module)
+		if (!module || id < 0)
 			return;
 			
 		if (module->learningId == id) {
@@ -174,63 +253,99 @@ struct MapModuleChoice : LedDisplayChoice {
 		}
 
 		// Set text
-		if (module->paramHandles[id].moduleId >= 0 && module->learningId != id) {
-			std::string prefix = "";
-			std::string label = getSlotLabel();
-			if (label == "") {
-				prefix = getSlotPrefix();
-				label = getParamName();
-				if (label == "") {
-					module->clearMap(id);
-					return;
-				}
-			}
-
-			size_t hscrollMaxLength = ceil(box.size.x / 6.2f);
-			if (module->textScrolling && label.length() + prefix.length() > hscrollMaxLength) {
-				// Scroll the parameter-name horizontically
-				text = prefix + label.substr(hscrollCharOffset > (int)label.length() ? 0 : hscrollCharOffset);
-				auto now = std::chrono::system_clock::now();
-				if (now - hscrollUpdate > std::chrono::milliseconds{100}) {
-					hscrollCharOffset = (hscrollCharOffset + 1) % (label.length() + hscrollMaxLength);
-					hscrollUpdate = now;
+		ParamHandle* paramHandle = &module->slots[id].paramHandle;
+		bool learning = module->learningId == id;
+		uint64_t version = getSlotVersion();
+		std::string label = getSlotLabel();
+		if (!textValid || textModuleId != paramHandle->moduleId || textParamId != paramHandle->paramId || textLearning != learning || textVersion != version || textLabel != label) {
+			textValid = true;
+			textModuleId = paramHandle->moduleId;
+			textParamId = paramHandle->paramId;
+			textLearning = learning;
+			textVersion = version;
+			textLabel = label;
+			textScrollOffset = -1;
+			if (paramHandle->moduleId >= 0 && !learning) {
+				textPrefix = "";
+				textName = label;
+				if (textName == "") {
+					textPrefix = getSlotPrefix();
+					textName = getParamName();
+					if (textName == "") {
+						textValid = false;
+						module->clearMap(id);
+						return;
+					}
 				}
+				text = textPrefix + textName;
 			} 
 			else {
-				text = prefix + label;
+				text = getSlotPrefix() + (learning ? "Mapping..." : "Unmapped");
 			}
-		} 
-		else {
-			if (module->learningId == id) {
-				text = getSlotPrefix() + "Mapping...";
-			} else {
-				text = getSlotPrefix() + "Unmapped";
+		}
+
+		size_t hscrollMaxLength = ceil(box.size.x / 6.2f);
+		if (paramHandle->moduleId >= 0 && !learning && module->textScrolling && textName.length() + textPrefix.length() > hscrollMaxLength) {
+			// Scroll the parameter-name horizontically
+			if (hscrollCharOffset != textScrollOffset) {
+				textScrollOffset = hscrollCharOffset;
+				text = textPrefix + textName.substr(hscrollCharOffset > (int)textName.length() ? 0 : hscrollCharOffset);
 			}
+			auto now = std::chrono::system_clock::now();
+			if (now - hscrollUpdate > std::chrono::milliseconds{100}) {
+				hscrollCharOffset = (hscrollCharOffset + 1) % (textName.length() + hscrollMaxLength);
+				hscrollUpdate = now;
+			}
+		} 
+		else if (textScrollOffset != -1) {
+			textScrollOffset = -1;
+			text = textPrefix + textName;
 		}
 
 		// Set text color
-		if (module->paramHandles[id].moduleId >= 0 || module->learningId == id) {
+		if (module->slots[id].paramHandle.moduleId >= 0 || module->learningId == id) {
 			color.a = 0.9;
 		} 
 		else {
 			color.a = 0.5;
 		}
+
+		if (fb->box.size.x != box.size.x || fb->box.size.y != box.size.y) {
+			fb->box.size = box.size;
+			fbText->box.size = box.size;
+			fb->setDirty();
+		}
+		if (text != drawnText || !isSameColor(color, drawnColor) || !isSameColor(bgColor, drawnBgColor)) {
+			drawnText = text;
+			drawnColor = color;
+			drawnBgColor = bgColor;
+			fb->setDirty();
+		}
+	}
+
+	static bool isSameColor(NVGcolor a, NVGcolor b) {
+		return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
 	}
 
 	virtual std::string getSlotLabel() {
 		return "";
 	}
 
+	/** Changes whenever the prefix of any slot may have changed */
+	virtual uint64_t getSlotVersion() {
+		return 0;
+	}
+
 	virtual std::string getSlotPrefix() {
-		return MAX_PARAMS > 1 ? string::f("%02d ", id + 1) : "";
+		return string::f("%02d ", id + 1);
 	}
 
 	ParamQuantity* getParamQuantity() {
 		if (!module)
 			return NULL;
-		if (id >= module->mapLen)
+		if (id < 0 || id >= module->getMapLen())
 			return NULL;
-		ParamHandle* paramHandle = &module->paramHandles[id];
+		ParamHandle* paramHandle = &module->slots[id].paramHandle;
 		if (paramHandle->moduleId < 0)
 			return NULL;
 		ModuleWidget *mw = APP->scene->rack->getModule(paramHandle->moduleId);
@@ -251,9 +366,9 @@ struct MapModuleChoice : LedDisplayChoice {
 	std::string getParamName() {
 		if (!module)
 			return "";
-		if (id >= module->mapLen)
+		if (id < 0 || id >= module->getMapLen())
 			return "";
-		ParamHandle* paramHandle = &module->paramHandles[id];
+		ParamHandle* paramHandle = &module->slots[id].paramHandle;
 		if (paramHandle->moduleId < 0)
 			return "";
 		ModuleWidget *mw = APP->scene->rack->getModule(paramHandle->moduleId);
@@ -276,29 +391,8 @@ struct MapModuleChoice : LedDisplayChoice {
 	}
 
 	void drawLayer(const DrawArgs& args, int layer) override {
-		if (layer == 1) {
-		if (bgColor.a > 0.0) {
-			nvgScissor(args.vg, RECT_ARGS(args.clipBox));
-			nvgBeginPath(args.vg);
-			nvgRect(args.vg, 0, 0, box.size.x, box.size.y);
-			nvgFillColor(args.vg, bgColor);
-			nvgFill(args.vg);
-			nvgResetScissor(args.vg);
-		}
-
-		std::shared_ptr<window::Font> font = APP->window->loadFont(fontPath);
-
-		if (font && font->handle >= 0) {
-			Rect r = Rect(textOffset.x, 0.f, box.size.x - textOffset.x * 2, box.size.y).intersect(args.clipBox);
-			nvgScissor(args.vg, RECT_ARGS(r));
-			nvgFillColor(args.vg, color);
-			nvgFontFaceId(args.vg, font->handle);
-			nvgTextLetterSpacing(args.vg, 0.0);
-			nvgFontSize(args.vg, 14);
-			nvgText(args.vg, textOffset.x, textOffset.y, text.c_str(), NULL);
-			nvgResetScissor(args.vg);
-		}
-		}
+		// Text is drawn by the framebuffer
+		Widget::drawLayer(args, layer);
 	}
 };
 
@@ -325,15 +419,21 @@ struct OscelotScrollWidget : ScrollWidget {
 	}
 };
 
-template< int MAX_PARAMS, typename MODULE, typename CHOICE = MapModuleChoice<MAX_PARAMS, MODULE> >
+template< typename MODULE, typename CHOICE = MapModuleChoice<MODULE> >
 struct MapModuleDisplay : LedDisplay {
 	MODULE* module;
 	ScrollWidget* scroll;
-	CHOICE* choices[MAX_PARAMS];
+	/** Gives the scroll container the height of all slots, rows are only created for the visible ones */
+	Widget* spacer;
+	std::vector<CHOICE*> rows;
+	std::vector<CHOICE*> freeRows;
+	/** Slots which got a row in the current step, sized to the number of slots */
+	std::vector<bool> shown;
+	float rowHeight;
 
 	~MapModuleDisplay() {
-		for (int id = 0; id < MAX_PARAMS; id++) {
-			choices[id]->processEvents = false;
+		for (CHOICE* row : rows) {
+			row->processEvents = false;
 		}
 	}
 
@@ -347,17 +447,64 @@ struct MapModuleDisplay : LedDisplay {
 
 		addChild(scroll);
 
-		Vec pos;
-		for (int id = 0; id < MAX_PARAMS; id++) {
-			CHOICE* choice = createWidget<CHOICE>(pos);
-			choice->box.size.x = box.size.x;
-			choice->id = id;
-			choice->setModule(module);
-			scroll->container->addChild(choice);
-			choices[id] = choice;
+		spacer = new Widget;
+		spacer->box.size.x = box.size.x;
+		scroll->container->addChild(spacer);
+		rowHeight = createRow()->box.size.y;
+	}
 
-			pos = choice->box.getBottomLeft();
+	CHOICE* createRow() {
+		CHOICE* row = createWidget<CHOICE>(Vec());
+		row->box.size.x = box.size.x;
+		row->setModule(module);
+		row->visible = false;
+		scroll->container->addChild(row);
+		rows.push_back(row);
+		return row;
+	}
+
+	/** Assigns the rows to the slots in the viewport, the row of a slot being learned is kept */
+	void step() override {
+		if (module) {
+			int mapLen = module->getMapLen();
+			spacer->box.size.y = mapLen * rowHeight;
+
+			int first = std::max(0, (int)std::floor(scroll->offset.y / rowHeight));
+			int last = std::min(mapLen, (int)std::ceil((scroll->offset.y + scroll->box.size.y) / rowHeight) + 1);
+			int learningId = module->learningId < mapLen ? module->learningId : -1;
+			auto isWanted = [&](int id) { return id >= 0 && ((id >= first && id < last) || id == learningId); };
+
+			shown.assign(mapLen, false);
+			freeRows.clear();
+			for (CHOICE* row : rows) {
+				if (isWanted(row->id) && !shown[row->id]) {
+					shown[row->id] = true;
+				} else {
+					freeRows.push_back(row);
+				}
+			}
+			auto show = [&](int id) {
+				if (shown[id]) return;
+				shown[id] = true;
+				CHOICE* row;
+				if (freeRows.empty()) {
+					row = createRow();
+				} else {
+					row = freeRows.back();
+					freeRows.pop_back();
+				}
+				row->setId(id);
+				row->box.pos.y = id * rowHeight;
+				row->visible = true;
+			};
+			for (int id = first; id < last; id++) show(id);
+			if (learningId >= 0) show(learningId);
+			for (CHOICE* row : freeRows) {
+				row->setId(-1);
+				row->visible = false;
+			}
 		}
+		LedDisplay::step();
 	}
 
 	void draw(const DrawArgs& args) override {
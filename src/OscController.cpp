@@ -3,72 +3,6 @@
 
 namespace TheModularMind {
 
-class OscFader : public OscController {
-   public:
-	OscFader(std::string address, int controllerId, CONTROLLERMODE controllerMode, float value, uint32_t ts) {
-		this->setTypeString("FDR");
-		this->setAddress(address);
-		this->setControllerId(controllerId);
-		this->setControllerMode(controllerMode);
-		OscController::setCurrentValue(value, ts);
-	}
-
-	virtual bool setCurrentValue(float value, uint32_t ts) override {
-		if (ts == 0 || ts > this->getTs()) {
-			return OscController::setCurrentValue(value, ts);
-		}
-		return false;
-	}
-};
-
-class OscEncoder : public OscController {
-   public:
-	OscEncoder(std::string address, int controllerId, float value, uint32_t ts, int sensitivity = ENCODER_DEFAULT_SENSITIVITY) {
-		this->setTypeString("ENC");
-		this->setAddress(address);
-		this->setControllerId(controllerId);
-		this->setControllerMode(CONTROLLERMODE::DIRECT);
-		this->setSensitivity(sensitivity);
-		this->setCurrentValue(value, ts);
-	}
-
-	virtual bool setCurrentValue(float value, uint32_t ts) override {
-		if (ts == 0) {
-			OscController::setCurrentValue(value, ts);
-		} else if (ts > this->getTs()) {
-			float newValue = this->getCurrentValue() + (value / float(sensitivity));
-			OscController::setCurrentValue(rack::math::clamp(newValue, 0.f, 1.f), ts);
-		}
-		return this->getCurrentValue() >= 0.f;
-	}
-
-	void setSensitivity(int sensitivity) override { this->sensitivity = sensitivity; }
-	int getSensitivity() override { return this->sensitivity; }
-
-   private:
-	int sensitivity = ENCODER_DEFAULT_SENSITIVITY;
-};
-
-class OscButton : public OscController {
-   public:
-	OscButton(std::string address, int controllerId, CONTROLLERMODE controllerMode, float value, uint32_t ts) {
-		this->setTypeString("BTN");
-		this->setAddress(address);
-		this->setControllerId(controllerId);
-		this->setControllerMode(controllerMode);
-		OscController::setCurrentValue(value, ts);
-	}
-
-	virtual bool setCurrentValue(float value, uint32_t ts) override {
-		if (ts == 0) {
-			OscController::setCurrentValue(value, ts);
-		} else if (ts > this->getTs()) {
-			OscController::setCurrentValue(rack::math::clamp(value, 0.f, 1.0f), ts);
-		}
-		return this->getCurrentValue() >= 0.f;
-	}
-};
-
 bool endsWith(std::string const &fullString, std::string const &ending) {
 	if (fullString.length() >= ending.length()) {
 		return (0 == fullString.compare(fullString.length() - ending.length(), ending.length(), ending));
@@ -77,16 +11,30 @@ bool endsWith(std::string const &fullString, std::string const &ending) {
 	}
 }
 
-OscController *OscController::Create(std::string address, int controllerId, CONTROLLERMODE controllerMode, float value, uint32_t ts) {
+bool OscController::init(const std::string &address, int controllerId, CONTROLLERMODE controllerMode) {
 	if (endsWith(address, "/fader")) {
-		return new OscFader(address, controllerId, controllerMode, value, ts);
+		type = CONTROLLERTYPE::FADER;
 	} else if (endsWith(address, "/encoder")) {
-		return new OscEncoder(address, controllerId, value, ts);
+		type = CONTROLLERTYPE::ENCODER;
+		// Encoders send relative values, toggle and pickup modes don't apply
+		controllerMode = CONTROLLERMODE::DIRECT;
 	} else if (endsWith(address, "/button")) {
-		return new OscButton(address, controllerId, controllerMode, value, ts);
-	} else
+		type = CONTROLLERTYPE::BUTTON;
+	} else {
 		INFO("Not Implemented for address: %s", address.c_str());
-	return nullptr;
-};
+		return false;
+	}
+	if (address.size() >= MAX_ADDRESS_LENGTH) {
+		INFO("Address too long: %s", address.c_str());
+		return false;
+	}
+	std::memcpy(this->address, address.c_str(), address.size() + 1);
+	addressLength = address.size();
+	this->controllerId = controllerId;
+	this->controllerMode = controllerMode;
+	sensitivity = ENCODER_DEFAULT_SENSITIVITY;
+	serial = 0;
+	return true;
+}
 
-}  // namespace TheModularMind
\ No newline at end of file
+}  // namespace TheModularMind
@@ -7,13 +7,38 @@
 #include "plugin.hpp"
 #include "ui/ParamWidgetContextExtender.hpp"
 #include "OscelotExpander.hpp"
+#include "OscelotCvExpander.hpp"
 
 namespace TheModularMind {
 namespace Oscelot {
 
 enum OSCMODE { OSCMODE_DEFAULT = 0, OSCMODE_LOCATE = 1 };
+enum AUTOCLIENT_REPLYPORT { AUTOCLIENT_REPLYPORT_SOURCE = 0, AUTOCLIENT_REPLYPORT_TX = 1 };
+
+/** State of a mapping slot besides its controller, which is kept in the mapping tables */
+struct OscelotSlot {
+	/** The mapped param handle */
+	ParamHandle paramHandle;
+	/**
+	 * Param the handle is changed to by updateParamHandles() while handlePending is set, both
+	 * written under the write mutex of mappingTables
+	 */
+	int64_t pendingModuleId = -1;
+	int pendingParamId = 0;
+	bool handlePending = false;
+	ParamHandleIndicator indicator;
+	OscelotParam oscParam;
+	/** Values of the controller of the slot, only used by the engine thread */
+	OscControllerState controllerState;
+	std::string textLabel;
+	/** Receive time of the first message since the slot was last evaluated by process() */
+	int64_t receiveTime = 0;
+	float expValue = -1.0f;
+	/** Written under the write mutex of mappingTables, followed by an increment of expLabelsVersion */
+	std::string expLabel = "None";
+};
 
-struct OscelotModule : Module, OscelotExpanderBase {
+struct OscelotModule : Module {
 	enum ParamIds { PARAM_RECV, PARAM_SEND, PARAM_PREV, PARAM_NEXT, PARAM_APPLY, PARAM_BANK, NUM_PARAMS };
 	enum InputIds { NUM_INPUTS };
 	enum OutputIds { NUM_OUTPUTS };
@@ -21,24 +46,67 @@ struct OscelotModule : Module, OscelotExpanderBase {
 
 	OscReceiver oscReceiver;
 	OscSender oscSender;
+	OscStats stats;
+	dsp::ClockDivider statsDivider;
+#ifdef OSCELOT_TRACE
+	/** Trace buffer of the engine thread, bound in process() which must not allocate it */
+	TraceBuffer* traceBuffer = TraceBuffer::create("engine");
+#endif
+	uint64_t statsPacketsOut = 0;
 	std::string ip = "localhost";
 	std::string rxPort = RXPORT_DEFAULT;
 	std::string txPort = TXPORT_DEFAULT;
 
 	int panelTheme = rand() % 4;
-	float expValues[MAX_PARAMS]={};
-	std::string expLabels[MAX_PARAMS]={};
-	/** Number of maps */
-	int mapLen = 0;
+	std::atomic<uint32_t> expLabelsVersion{0};
+	/** Set when the engine thread changed an expValue, changes by the UI are found by comparison */
+	bool expValuesChanged = false;
+	ExpanderMessages expanderMessages;
+	dsp::ClockDivider expanderDivider;
+	/** Version of the message of the CV send expander last sent */
+	uint32_t cvVersion = 0;
+	bool cvResend = false;
+	/** Address prefix the channel addresses were built for */
+	char cvAddress[CvMessage::ADDRESS_LENGTH] = {};
+	/** <address>/<input>/<channel> of every channel, built when the address changes */
+	char cvChannelAddresses[CvMessage::NUM_INPUTS][16][CvMessage::ADDRESS_LENGTH + 8] = {};
+	/** Encode buffer of the CV bundle, large enough for all channels */
+	char cvBuffer[CvMessage::NUM_INPUTS * 16 * (CvMessage::ADDRESS_LENGTH + 24) + 32];
+	osc::OutboundPacketStream cvStream{cvBuffer, sizeof(cvBuffer)};
 	bool oscIgnoreDevices;
 	bool clearMapsOnLoad;
     bool alwaysSendFullFeedback;
-	/** The mapped param handle of each channel */
-	ParamHandle paramHandles[MAX_PARAMS];
-	std::string textLabels[MAX_PARAMS];
-	OscelotParam oscParam[MAX_PARAMS];
-	OscController* oscControllers[MAX_PARAMS];
-	ParamHandleIndicator paramHandleIndicator[MAX_PARAMS];
+	/**
+	 * Per-slot state, grown in blocks of SLOT_BLOCK_SIZE by growSlots() outside of the engine
+	 * thread. The capacity of the mapping tables follows with the next publish.
+	 */
+	SlotStorage<OscelotSlot, SLOT_BLOCK_SIZE> slots;
+	/**
+	 * Rack's engine, APP is only set on the UI and the engine thread while param handles are
+	 * also added and updated by the stager thread
+	 */
+	engine::Engine* engine;
+	/** Number of slots requested by the engine thread or by loading, served by the stager thread */
+	std::atomic<int> slotDemand{0};
+	/** Set under the write mutex when pendingMappings are waiting for more slots */
+	std::atomic<bool> reapplyMappings{false};
+	/** OSC controllers of all slots, published as immutable snapshots for the engine and the UI */
+	MappingTables mappingTables{SLOT_BLOCK_SIZE};
+	/** Scratch space of applyMappings() and bankSwap() sized to the slots, used under the write mutex */
+	std::vector<uint8_t> changedSlots;
+	/** Set under the write mutex while updateParamHandles() changes handles outside of it */
+	bool paramHandlesUpdating = false;
+	/** Serializes updateParamHandles(), never locked while holding the write mutex or the engine */
+	std::mutex paramHandleMutex;
+	struct ParamHandleUpdate {
+		int id;
+		int64_t moduleId;
+		int paramId;
+	};
+	std::vector<ParamHandleUpdate> paramHandleUpdates;
+	/** Mappings which didn't fit into the slots, applied again by processSlotDemand() */
+	std::vector<BankMeowMoryParam> pendingMappings;
+	bool pendingKeepOscMappings = false;
 
 	/** Channel ID of the learning session */
 	int learningId;
@@ -57,15 +125,49 @@ struct OscelotModule : Module, OscelotExpanderBase {
 	uint32_t ts = 0;
 
 	OSCMODE oscMode = OSCMODE::OSCMODE_DEFAULT;
+	/** Mode last seen by the engine thread */
+	OSCMODE processedOscMode = OSCMODE::OSCMODE_DEFAULT;
 	bool oscResendPeriodically;
 	dsp::ClockDivider oscResendDivider;
+	std::atomic<bool> oscResendRequested{false};
+	/** Register every remote endpoint sending messages as feedback destination */
+	bool oscAutoClients;
+	AUTOCLIENT_REPLYPORT autoClientReplyPort;
+	/** Idle time in seconds after which registered clients are removed */
+	int autoClientTimeout;
+	dsp::ClockDivider autoClientDivider;
+	/** Feedback limit per destination in packets/bytes per second, 0 = unlimited */
+	int feedbackPacketRate;
+	int feedbackByteRate;
+	/** Handling of feedback for the client which changed a slot itself */
+	ECHOMODE echoMode;
+	/** Hold time in milliseconds */
+	int echoHoldTime;
+	bool echoMatchPort;
+	/** Newly registered clients waiting for their initial snapshot */
+	std::vector<uint32_t> snapshotClientIds;
+	struct SubscriptionRequest {
+		IpEndpointName endpoint;
+		int sourcePort;
+		int first;
+		int count;
+		bool subscribe;
+	};
+	static const int MAX_SUBSCRIPTION_REQUESTS = 16;
+	/** Subscriptions which found the destinations locked by the UI, retried in order by process() */
+	SubscriptionRequest subscriptionRequests[MAX_SUBSCRIPTION_REQUESTS];
+	int subscriptionRequestCount = 0;
 	dsp::ClockDivider processDivider;
 	dsp::ClockDivider lightDivider;
 	int processDivision;
 	dsp::ClockDivider indicatorDivider;
 
 	std::map<std::string, ModuleMeowMory> meowMoryStorage;
+	/** Has to be invalidated on every change of meowMoryStorage */
+	ModuleMeowMoryIndex meowMoryIndex;
 	BankMeowMory meowMoryBankStorage[128];
+	/** Pre-compiled tables of all banks for switching without allocations in process() */
+	BankStager bankStager{meowMoryBankStorage};
 	int currentBankIndex = 0;
 	int64_t meowMoryModuleId = -1;
 	std::string contextLabel = "";
@@ -83,6 +185,7 @@ struct OscelotModule : Module, OscelotExpanderBase {
 	dsp::SchmittTrigger meowMoryParamTrigger;
 
 	OscelotModule() {
+		engine = APP->engine;
 		config(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS);
 		configParam(PARAM_RECV, 0.0f, 1.0f, 0.0f, "Enable Receiver");
 		configParam(PARAM_SEND, 0.0f, 1.0f, 0.0f, "Enable Sender");
@@ -91,25 +194,84 @@ struct OscelotModule : Module, OscelotExpanderBase {
 		configParam(PARAM_APPLY, 0.f, 1.f, 0.f, "Apply mapping");
 		configParam(PARAM_BANK, 0, 127, 0, "Bank", "", 0.f, 1.f, 1);
 
-		for (int id = 0; id < MAX_PARAMS; id++) {
-			paramHandleIndicator[id].color = mappingIndicatorColor;
-			paramHandleIndicator[id].handle = &paramHandles[id];
-			APP->engine->addParamHandle(&paramHandles[id]);
-			oscParam[id].setLimits(0.0f, 1.0f, -1.0f);
-		}
+		growSlots(SLOT_BLOCK_SIZE);
 		indicatorDivider.setDivision(2048);
 		lightDivider.setDivision(2048);
 		oscResendDivider.setDivision(APP->engine->getSampleRate() / 2);
+		autoClientDivider.setDivision(APP->engine->getSampleRate());
+		statsDivider.setDivision(APP->engine->getSampleRate());
+		oscReceiver.stats = &stats;
+		oscSender.stats = &stats;
 		onReset();
+		mappingTables.setOnline(MappingTables::READER_ENGINE, true);
+		bankStager.idleCallback = [this]() {
+			mappingTables.collect();
+			processSlotDemand();
+		};
+		bankStager.start();
 	}
 
 	~OscelotModule() {
-		for (int id = 0; id < MAX_PARAMS; id++) {
-			APP->engine->removeParamHandle(&paramHandles[id]);
+		bankStager.stop();
+		for (int id = 0; id < slots.size(); id++) {
+			engine->removeParamHandle(&slots[id].paramHandle);
 		}
 	}
 
-	void resetMapMemory() { meowMoryStorage.clear(); }
+	/**
+	 * Adds blocks of slots until there are at least count of them and grows the mapping tables
+	 * and the staged banks along. Adding param handles locks the engine, so this is never called
+	 * on the engine thread, while loading or while holding the write mutex, the first two request
+	 * slots with requestSlots().
+	 */
+	void growSlots(int count) {
+		if (count > slots.size()) {
+			slots.grow(count, [this](int id, OscelotSlot& slot) {
+				slot.indicator.color = mappingIndicatorColor;
+				slot.indicator.handle = &slot.paramHandle;
+				slot.oscParam.setLimits(0.0f, 1.0f, -1.0f);
+				engine->addParamHandle(&slot.paramHandle);
+			});
+		}
+
+		std::lock_guard<std::mutex> lock(mappingTables.getWriteMutex());
+		int capacity = slots.size();
+		if ((int)changedSlots.size() < capacity) changedSlots.resize(capacity);
+		bankStager.setCapacity(capacity);
+		if (capacity <= mappingTables.getCapacity()) return;
+		mappingTables.setCapacity(capacity);
+		MappingTable* table = mappingTables.edit();
+		updateMapLen(table);
+		mappingTables.publish(table);
+		expLabelsVersion++;
+	}
+
+	/** Slots are grown to count by the stager thread, doesn't allocate */
+	void requestSlots(int count) {
+		int demand = slotDemand.load();
+		while (demand < count && !slotDemand.compare_exchange_weak(demand, count)) {
+		}
+	}
+
+	/** Serves requestSlots() and maps the pending mappings afterwards, called by the stager thread */
+	void processSlotDemand() {
+		int demand = slotDemand.load();
+		if (demand > slots.size()) growSlots(demand);
+		if (!reapplyMappings) return;
+		{
+			std::lock_guard<std::mutex> lock(mappingTables.getWriteMutex());
+			if (!reapplyMappings || (int)pendingMappings.size() > mappingTables.getCapacity()) return;
+			std::vector<BankMeowMoryParam> mappings;
+			mappings.swap(pendingMappings);
+			applyMappings(mappings, pendingKeepOscMappings);
+		}
+		updateParamHandles();
+	}
+
+	void resetMapMemory() {
+		meowMoryStorage.clear();
+		meowMoryIndex.invalidate();
+	}
 
 	void onReset() override {
 		receiving = false;
@@ -120,15 +282,19 @@ struct OscelotModule : Module, OscelotExpanderBase {
 		learnedControllerId = false;
 		learnedParam = false;
 		clearMaps(false);
-		mapLen = 1;
-		for (int i = 0; i < MAX_PARAMS; i++) {
-			oscControllers[i] = nullptr;
-			textLabels[i] = "";
-			expValues[i]=-1.0f;
-			expLabels[i] = "None";
+		for (int i = 0; i < slots.size(); i++) {
+			slots[i].textLabel = "";
+			slots[i].receiveTime = 0;
+			slots[i].expValue=-1.0f;
+			slots[i].expLabel = "None";
 		}
-		for (int bankIndex = 0; bankIndex < 128; bankIndex++) {
-			meowMoryBankStorage[bankIndex] = BankMeowMory();
+		expLabelsVersion++;
+		{
+			std::lock_guard<std::mutex> lock(bankStager.getMutex());
+			for (int bankIndex = 0; bankIndex < 128; bankIndex++) {
+				meowMoryBankStorage[bankIndex] = BankMeowMory();
+			}
+			bankStager.invalidateAll();
 		}
 		locked = false;
 		oscIgnoreDevices = false;
@@ -139,10 +305,20 @@ struct OscelotModule : Module, OscelotExpanderBase {
 		processDivider.reset();
 		clearMapsOnLoad = false;
 		alwaysSendFullFeedback = false;
-		rightExpander.producerMessage = NULL;
+		setAutoClients(false);
+		autoClientReplyPort = AUTOCLIENT_REPLYPORT_SOURCE;
+		autoClientTimeout = 30;
+		setFeedbackRateLimit(0, 0);
+		setEchoSuppression(ECHOMODE_OFF, 250, false);
+		expanderMessages.attach(rightExpander);
+		expanderDivider.setDivision(64);
 	}
 
-	void onSampleRateChange() override { oscResendDivider.setDivision(APP->engine->getSampleRate() / 2); }
+	void onSampleRateChange() override {
+		oscResendDivider.setDivision(APP->engine->getSampleRate() / 2);
+		autoClientDivider.setDivision(APP->engine->getSampleRate());
+		statsDivider.setDivision(APP->engine->getSampleRate());
+	}
 
 	bool isValidPort(std::string port) {
 		bool isValid = false;
@@ -182,36 +358,229 @@ struct OscelotModule : Module, OscelotExpanderBase {
 		}
 	}
 
-	void sendOscFeedback(int id) {
+	bool addDestination(std::string host, int port, bool enabled = true) {
+		if (host == "" || port <= 0 || port > 65535) return false;
+		if (!oscSender.addDestination(host, port, enabled)) {
+			WARN("Could not resolve OSC feedback destination %s:%i", host.c_str(), port);
+			return false;
+		}
+		INFO("Added OSC feedback destination %s:%i", host.c_str(), port);
+		return true;
+	}
+
+	void setAutoClients(bool enabled) {
+		oscAutoClients = enabled;
+		if (!enabled) oscSender.removeAutoRegisteredClients();
+	}
+
+	int getReplyPort(const OscMessage& msg) { return autoClientReplyPort == AUTOCLIENT_REPLYPORT_TX ? oscSender.port : msg.getRemotePort(); }
+
+	void registerClient(const OscMessage& msg) {
+		int replyPort = getReplyPort(msg);
+		if (replyPort <= 0 || !msg.getRemoteAddress()) return;
+		uint32_t clientId = oscSender.touchClient(IpEndpointName(msg.getRemoteAddress(), replyPort), msg.getRemotePort(), system::getTime());
+		if (clientId) {
+			INFO("Registered OSC client %s:%i", msg.getRemoteHost().c_str(), replyPort);
+			snapshotClientIds.push_back(clientId);
+		}
+	}
+
+	/** Handles /oscelot/subscribe and /oscelot/unsubscribe with the arguments first slot and count */
+	void subscribeClient(const OscMessage& msg, bool subscribe) {
+		int replyPort = getReplyPort(msg);
+		if (replyPort <= 0 || !msg.getRemoteAddress()) return;
+
+		// Ranges may include slots which don't exist yet, without a range all slots are subscribed
+		SubscriptionRequest request;
+		request.endpoint = IpEndpointName(msg.getRemoteAddress(), replyPort);
+		request.sourcePort = msg.getRemotePort();
+		request.first = 0;
+		request.count = -1;
+		request.subscribe = subscribe;
+		if (msg.getNumArgs() >= 2) {
+			request.first = getArgAsInt(msg, 0);
+			request.count = getArgAsInt(msg, 1);
+		}
+		// Dropped if the UI has been holding the destinations for a long time
+		if (subscriptionRequestCount > 0 || !applySubscription(request)) {
+			if (subscriptionRequestCount < MAX_SUBSCRIPTION_REQUESTS) subscriptionRequests[subscriptionRequestCount++] = request;
+		}
+	}
+
+	/** False if the destinations are locked right now */
+	bool applySubscription(const SubscriptionRequest& request) {
+		uint32_t clientId = oscSender.setSubscription(request.endpoint, request.sourcePort, request.first, request.count, request.subscribe, system::getTime());
+		if (clientId == OscSender::DESTINATIONS_BUSY) return false;
+		if (!clientId || !request.subscribe || request.first < 0 || request.count == 0) return true;
+
+		// Snapshot of the subscribed range
+		const MappingTable* table = mappingTables.get();
+		int last = request.count < 0 ? table->mapLen : (int)std::min((int64_t)request.first + request.count, (int64_t)table->mapLen);
+		for (int id = request.first; id < last; id++) {
+			if (!table->controllers[id] || slots[id].paramHandle.moduleId < 0) continue;
+			oscSender.queueFeedback(clientId, id, true);
+		}
+		return true;
+	}
+
+	void retrySubscriptions() {
+		int done = 0;
+		while (done < subscriptionRequestCount && applySubscription(subscriptionRequests[done])) done++;
+		std::copy(subscriptionRequests + done, subscriptionRequests + subscriptionRequestCount, subscriptionRequests);
+		subscriptionRequestCount -= done;
+	}
+
+	/** Answers /oscelot/stats with name/value pairs of all counters */
+	void sendStats(const OscMessage& msg) {
+		int replyPort = getReplyPort(msg);
+		if (!sending || replyPort <= 0 || !msg.getRemoteAddress()) return;
+
+		OscMessage statsMessage;
+		statsMessage.setAddress("/oscelot/stats");
+		// Counters are sent as int64, byte counters overflow int32 within hours
+		auto addInt = [&](const char* name, uint64_t value) {
+			statsMessage.addStringArg(name);
+			statsMessage.addInt64Arg((int64_t)std::min<uint64_t>(value, INT64_MAX));
+		};
+		auto addFloat = [&](const char* name, float value) {
+			statsMessage.addStringArg(name);
+			statsMessage.addFloatArg(value);
+		};
+		addInt("packetsIn", stats.packetsIn);
+		addInt("bytesIn", stats.bytesIn);
+		addInt("messagesIn", stats.messagesIn);
+		addInt("parseErrors", stats.parseErrors);
+		addInt("unknownAddresses", stats.unknownAddresses);
+		addInt("invalidMessages", stats.invalidMessages);
+		addInt("packetsOut", stats.packetsOut);
+		addInt("bytesOut", stats.bytesOut);
+		addInt("queueHighWater", stats.queueHighWater);
+		addFloat("feedbackRate", stats.feedbackRate);
+		addFloat("tickTime", stats.tickTime);
+		addFloat("tickTimeMax", stats.tickTimeMax);
+		addFloat("tickTimeAvg", stats.tickTimeAvg);
+		addFloat("latencyP50", stats.latency.getPercentile(0.5f) / 1000.f);
+		addFloat("latencyP99", stats.latency.getPercentile(0.99f) / 1000.f);
+		addFloat("latencyMax", stats.latency.max / 1000.f);
+		oscSender.sendMessageTo(statsMessage, IpEndpointName(msg.getRemoteAddress(), replyPort));
+	}
+
+	void resetStats() {
+		stats.reset();
+		statsPacketsOut = 0;
+	}
+
+	static bool isNumberArg(const OscMessage& msg, size_t index) {
+		osc::TypeTagValues type = msg.getArgType(index);
+		return type == osc::INT32_TYPE_TAG || type == osc::FLOAT_TYPE_TAG;
+	}
+
+	float getArgAsFloat(const OscMessage& msg, size_t index) {
+		switch (msg.getArgType(index)) {
+		case osc::INT32_TYPE_TAG:
+			return (float)msg.getArgAsInt(index);
+		case osc::FLOAT_TYPE_TAG:
+			return msg.getArgAsFloat(index);
+		default:
+			return 0.f;
+		}
+	}
+
+	int getArgAsInt(const OscMessage& msg, size_t index) {
+		switch (msg.getArgType(index)) {
+		case osc::INT32_TYPE_TAG:
+			return msg.getArgAsInt(index);
+		case osc::FLOAT_TYPE_TAG:
+			return (int)msg.getArgAsFloat(index);
+		default:
+			return 0;
+		}
+	}
+
+	/** Values of the controller of a slot, only used by the engine thread */
+	OscControllerState& getControllerState(int id, const OscController* controller) {
+		controller->updateState(slots[id].controllerState);
+		return slots[id].controllerState;
+	}
+
+	OscBundle getFeedbackBundle(int id, const OscController* controller, bool fullFeedback) {
 		OscBundle feedbackBundle;
 		OscMessage valueMessage;
 		
-		valueMessage.setAddress(oscControllers[id]->getAddress());
-		valueMessage.addIntArg(oscControllers[id]->getControllerId());
-		valueMessage.addFloatArg(oscControllers[id]->getCurrentValue());
+		valueMessage.setAddress(controller->getAddress());
+		valueMessage.addIntArg(controller->getControllerId());
+		valueMessage.addFloatArg(getControllerState(id, controller).getCurrentValue());
 		feedbackBundle.addMessage(valueMessage);
 
-		if (alwaysSendFullFeedback || oscParam[id].hasChanged) {
+		if (fullFeedback) {
 			OscMessage infoMessage;
-			oscParam[id].hasChanged = false;
-
-			infoMessage.setAddress(oscControllers[id]->getAddress() + "/info");
-			infoMessage.addIntArg(oscControllers[id]->getControllerId());
+			infoMessage.setAddress(controller->getAddress() + "/info");
+			infoMessage.addIntArg(controller->getControllerId());
 			for (auto&& infoArg : getParamInfo(id)) {
 				infoMessage.addOscArg(infoArg);
 			}
 			feedbackBundle.addMessage(infoMessage);
 		}
+		return feedbackBundle;
+	}
+
+	void sendOscFeedback(int id, const OscController* controller) {
+		TRACE_ZONE("sendOscFeedback");
+		bool fullFeedback = alwaysSendFullFeedback || slots[id].oscParam.hasChanged;
+		if (fullFeedback) slots[id].oscParam.hasChanged = false;
+		oscSender.sendFeedback(id, fullFeedback, getFeedbackBundle(id, controller, fullFeedback));
+	}
+
+	/** Queues full feedback of all mapped slots for a single client, sent respecting the rate limit */
+	void sendOscSnapshot(uint32_t clientId) {
+		const MappingTable* table = mappingTables.get();
+		for (int id = 0; id < table->mapLen; id++) {
+			if (!table->controllers[id] || slots[id].paramHandle.moduleId < 0) continue;
+			oscSender.queueFeedback(clientId, id, true);
+		}
+	}
+
+	void flushOscFeedback() {
+		const MappingTable* table = mappingTables.get();
+		oscSender.flushPendingFeedback([this, table](int id, bool fullFeedback, OscBundle& bundle) {
+			if (id >= table->mapLen || !table->controllers[id] || slots[id].paramHandle.moduleId < 0) return false;
+			bundle = getFeedbackBundle(id, table->controllers[id], fullFeedback);
+			return true;
+		});
+	}
+
+	void setEchoSuppression(ECHOMODE mode, int holdTime, bool matchPort) {
+		echoMode = mode;
+		echoHoldTime = holdTime;
+		echoMatchPort = matchPort;
+		oscSender.setEchoSuppression(mode, holdTime / 1000.f, matchPort);
+	}
+
+	void setFeedbackRateLimit(int packetRate, int byteRate) {
+		feedbackPacketRate = packetRate;
+		feedbackByteRate = byteRate;
+		oscSender.setRateLimit(packetRate, byteRate);
+	}
 
-		oscSender.sendBundle(feedbackBundle);
+	void processBypass(const ProcessArgs& args) override {
+		// Holds no mapping table while bypassed, replaced tables can still be reclaimed
+		TRACE_BIND(traceBuffer);
+		mappingTables.quiescent(MappingTables::READER_ENGINE);
+		Module::processBypass(args);
 	}
 
 	void process(const ProcessArgs& args) override {
+		TRACE_BIND(traceBuffer);
+		TRACE_ZONE("process");
+		// No mapping table or controller pointer is kept across calls of process()
+		mappingTables.quiescent(MappingTables::READER_ENGINE);
 		ts++;
 		if (params[PARAM_BANK].getValue() != currentBankIndex) {
-			bankMeowMorySave(currentBankIndex);
-			currentBankIndex = params[PARAM_BANK].getValue();
-			bankMeowMoryApply(currentBankIndex);
+			bankSwitch(params[PARAM_BANK].getValue());
+		}
+		if (oscMode != processedOscMode) {
+			processedOscMode = oscMode;
+			if (processedOscMode == OSCMODE::OSCMODE_LOCATE) startLocate();
 		}
 		OscMessage rxMessage;
 		while (oscReceiver.shift(&rxMessage)) {
@@ -263,17 +632,24 @@ struct OscelotModule : Module, OscelotExpanderBase {
 		// Only step channels when some osc event has been received. Additionally
 		// step channels for parameter changes made manually every 128th loop. 
 		if (processDivider.process() || oscReceived) {
+			double tickStart = system::getTime();
 			// Step channels
-			for (int id = 0; id < mapLen; id++) {
-				if (!oscControllers[id]) continue;
-				int controllerId = oscControllers[id]->getControllerId();
+			const MappingTable* table = mappingTables.get();
+			for (int id = 0; id < table->mapLen; id++) {
+				const OscController* controller = table->controllers[id];
+				if (!controller) continue;
+				OscControllerState& state = getControllerState(id, controller);
+				int controllerId = controller->getControllerId();
+				// Taken on every evaluation, a message which doesn't write the parameter leaves no stale stamp
+				int64_t receiveTime = slots[id].receiveTime;
+				slots[id].receiveTime = 0;
 
 				// Get Module
-				Module* module = paramHandles[id].module;
+				Module* module = slots[id].paramHandle.module;
 				if (!module) continue;
 
 				// Get ParamQuantity
-				int paramId = paramHandles[id].paramId;
+				int paramId = slots[id].paramHandle.paramId;
 				ParamQuantity* paramQuantity = module->paramQuantities[paramId];
 				if (!paramQuantity) continue;
 
@@ -281,87 +657,89 @@ struct OscelotModule : Module, OscelotExpanderBase {
 
 				switch (oscMode) {
 				case OSCMODE::OSCMODE_DEFAULT: {
-					oscParam[id].paramQuantity = paramQuantity;
+					slots[id].oscParam.paramQuantity = paramQuantity;
 					float currentControllerValue = -1.0f;
 
 					// Check if controllerId value has been set and changed
 					if (controllerId >= 0 && oscReceived) {
-						switch (oscControllers[id]->getControllerMode()) {
+						switch (controller->getControllerMode()) {
 						case CONTROLLERMODE::DIRECT:
-							if (oscControllers[id]->getValueIn() != oscControllers[id]->getCurrentValue()) {
-								oscControllers[id]->setValueIn(oscControllers[id]->getCurrentValue());
-								currentControllerValue = oscControllers[id]->getCurrentValue();
+							if (state.getValueIn() != state.getCurrentValue()) {
+								state.setValueIn(state.getCurrentValue());
+								currentControllerValue = state.getCurrentValue();
 							}
 							break;
 						case CONTROLLERMODE::PICKUP1:
-							if (oscControllers[id]->getValueIn() != oscControllers[id]->getCurrentValue()) {
-								if (oscParam[id].isNear(oscControllers[id]->getValueIn())) {
-									currentControllerValue = oscControllers[id]->getCurrentValue();
+							if (state.getValueIn() != state.getCurrentValue()) {
+								if (slots[id].oscParam.isNear(state.getValueIn())) {
+									currentControllerValue = state.getCurrentValue();
 								}
-								oscControllers[id]->setValueIn(oscControllers[id]->getCurrentValue());
+								state.setValueIn(state.getCurrentValue());
 							}
 							break;
 						case CONTROLLERMODE::PICKUP2:
-							if (oscControllers[id]->getValueIn() != oscControllers[id]->getCurrentValue()) {
-								if (oscParam[id].isNear(oscControllers[id]->getValueIn(), oscControllers[id]->getCurrentValue())) {
-									currentControllerValue = oscControllers[id]->getCurrentValue();
+							if (state.getValueIn() != state.getCurrentValue()) {
+								if (slots[id].oscParam.isNear(state.getValueIn(), state.getCurrentValue())) {
+									currentControllerValue = state.getCurrentValue();
 								}
-								oscControllers[id]->setValueIn(oscControllers[id]->getCurrentValue());
+								state.setValueIn(state.getCurrentValue());
 							}
 							break;
 						case CONTROLLERMODE::TOGGLE:
-							if (oscControllers[id]->getCurrentValue() > 0 && (oscControllers[id]->getValueIn() == -1.f || oscControllers[id]->getValueIn() >= 0.f)) {
-								currentControllerValue = oscParam[id].getLimitMax();
-								oscControllers[id]->setValueIn(-2.f);
-							} else if (oscControllers[id]->getCurrentValue() == 0.f && oscControllers[id]->getValueIn() == -2.f) {
-								currentControllerValue = oscParam[id].getLimitMax();
-								oscControllers[id]->setValueIn(-3.f);
-							} else if (oscControllers[id]->getCurrentValue() > 0.f && oscControllers[id]->getValueIn() == -3.f) {
-								currentControllerValue = oscParam[id].getLimitMin();
-								oscControllers[id]->setValueIn(-4.f);
-							} else if (oscControllers[id]->getCurrentValue() == 0.f && oscControllers[id]->getValueIn() == -4.f) {
-								currentControllerValue = oscParam[id].getLimitMin();
-								oscControllers[id]->setValueIn(-1.f);
+						case CONTROLLERMODE::TOGGLE_VALUE: {
+							bool toggleValue = controller->getControllerMode() == CONTROLLERMODE::TOGGLE_VALUE;
+							bool pressed = state.getCurrentValue() > 0.f;
+							bool released = state.getCurrentValue() == 0.f;
+							switch (state.toggleState) {
+							case TOGGLESTATE::IDLE:
+								if (!pressed) break;
+								currentControllerValue = toggleValue ? state.getCurrentValue() : slots[id].oscParam.getLimitMax();
+								state.toggleState = TOGGLESTATE::PRESSED_ON;
+								break;
+							case TOGGLESTATE::PRESSED_ON:
+								if (!released) break;
+								currentControllerValue = toggleValue ? slots[id].oscParam.getValue() : slots[id].oscParam.getLimitMax();
+								state.toggleState = TOGGLESTATE::RELEASED_ON;
+								break;
+							case TOGGLESTATE::RELEASED_ON:
+								if (!pressed) break;
+								currentControllerValue = slots[id].oscParam.getLimitMin();
+								state.toggleState = TOGGLESTATE::PRESSED_OFF;
+								break;
+							case TOGGLESTATE::PRESSED_OFF:
+								if (!released) break;
+								currentControllerValue = slots[id].oscParam.getLimitMin();
+								state.toggleState = TOGGLESTATE::IDLE;
+								break;
 							}
-							break;
-						case CONTROLLERMODE::TOGGLE_VALUE:
-							if (oscControllers[id]->getCurrentValue() > 0 && (oscControllers[id]->getValueIn() == -1.f || oscControllers[id]->getValueIn() >= 0.f)) {
-								currentControllerValue = oscControllers[id]->getCurrentValue();
-								oscControllers[id]->setValueIn(-2.f);
-							} else if (oscControllers[id]->getCurrentValue() == 0.f && oscControllers[id]->getValueIn() == -2.f) {
-								currentControllerValue = oscParam[id].getValue();
-								oscControllers[id]->setValueIn(-3.f);
-							} else if (oscControllers[id]->getCurrentValue() > 0.f && oscControllers[id]->getValueIn() == -3.f) {
-								currentControllerValue = oscParam[id].getLimitMin();
-								oscControllers[id]->setValueIn(-4.f);
-							} else if (oscControllers[id]->getCurrentValue() == 0.f && oscControllers[id]->getValueIn() == -4.f) {
-								currentControllerValue = oscParam[id].getLimitMin();
-								oscControllers[id]->setValueIn(-1.f);
-							}
-							break;
+						} break;
 						}
 					}
 
 					// Set a new value for the mapped parameter
 					if (currentControllerValue >= 0.f) {
-						oscParam[id].setValue(currentControllerValue);
+						slots[id].oscParam.setValue(currentControllerValue);
 					}
 
-					// Apply value on the mapped parameter (respecting slew and scale)
-					oscParam[id].process(args.sampleTime * float(processDivision));
+					// Apply value on the mapped parameter (respecting slew and scale), latency only of writes caused by a message
+					if (slots[id].oscParam.process(args.sampleTime * float(processDivision)) && currentControllerValue >= 0.f && receiveTime > 0) {
+						stats.latency.record(LatencyHistogram::now() - receiveTime);
+					}
 
 					// Retrieve the current value of the parameter (ignoring slew and scale)
-					float currentParamValue = oscParam[id].getValue();
+					float currentParamValue = slots[id].oscParam.getValue();
 
 					// OSC feedback
-					if (oscControllers[id]->getValueOut() != paramQuantity->getDisplayValueString()) {
-						if (controllerId >= 0 && oscControllers[id]->getControllerMode() == CONTROLLERMODE::DIRECT) oscControllers[id]->setValueIn(currentParamValue);
-
-						oscControllers[id]->setCurrentValue(currentParamValue, 0);
-						expValues[id]=currentParamValue;
-						oscControllers[id]->setValueOut(paramQuantity->getDisplayValueString());
+					uint64_t valueOut = OscController::hashValue(paramQuantity->getDisplayValueString());
+					if (state.isValueOutChanged(valueOut)) {
+						if (controllerId >= 0 && controller->getControllerMode() == CONTROLLERMODE::DIRECT) state.setValueIn(currentParamValue);
+
+						controller->setCurrentValue(state, currentParamValue, 0);
+						slots[id].expValue=currentParamValue;
+						expValuesChanged = true;
+						state.setValueOut(valueOut);
 						if (sending) {
-							sendOscFeedback(id);
+							sendOscFeedback(id, controller);
 							oscSent = true;
 						}
 					}
@@ -369,26 +747,53 @@ struct OscelotModule : Module, OscelotExpanderBase {
 
 				case OSCMODE::OSCMODE_LOCATE: {
 					bool indicate = false;
-					if ((controllerId >= 0 && oscControllers[id]->getCurrentValue() >= 0) && oscControllers[id]->getValueIndicate() != oscControllers[id]->getCurrentValue()) {
-						oscControllers[id]->setValueIndicate(oscControllers[id]->getCurrentValue());
+					if ((controllerId >= 0 && state.getCurrentValue() >= 0) && state.getValueIndicate() != state.getCurrentValue()) {
+						state.setValueIndicate(state.getCurrentValue());
 						indicate = true;
 					}
 					if (indicate) {
 						ModuleWidget* mw = APP->scene->rack->getModule(paramQuantity->module->id);
-						paramHandleIndicator[id].indicate(mw);
+						slots[id].indicator.indicate(mw);
 					}
 				} break;
 				}
 			}
+
+			if (sending && oscSender.hasPendingFeedback()) {
+				flushOscFeedback();
+				oscSent = true;
+			}
+			stats.addTickTime((system::getTime() - tickStart) * 1e6);
+		}
+
+		if (statsDivider.process()) {
+			uint64_t packetsOut = stats.packetsOut;
+			stats.feedbackRate = float(packetsOut - std::min(statsPacketsOut, packetsOut)) * statsDivider.getDivision() * args.sampleTime;
+			statsPacketsOut = packetsOut;
 		}
 		oscReceived = false;
 
+		if (subscriptionRequestCount > 0) retrySubscriptions();
+
+		if (sending && !snapshotClientIds.empty()) {
+			for (uint32_t clientId : snapshotClientIds) {
+				sendOscSnapshot(clientId);
+			}
+			snapshotClientIds.clear();
+			oscSent = true;
+		}
+
+		if (oscAutoClients && autoClientDivider.process()) {
+			oscSender.expireClients(system::getTime(), autoClientTimeout);
+		}
+
 		if (indicatorDivider.process()) {
 			float t = indicatorDivider.getDivision() * args.sampleTime;
+			int mapLen = getMapLen();
 			for (int i = 0; i < mapLen; i++) {
-				paramHandleIndicator[i].color = mappingIndicatorHidden ? color::BLACK_TRANSPARENT : mappingIndicatorColor;
-				if (paramHandles[i].moduleId >= 0) {
-					paramHandleIndicator[i].process(t, learningId == i);
+				slots[i].indicator.color = mappingIndicatorHidden ? color::BLACK_TRANSPARENT : mappingIndicatorColor;
+				if (slots[i].paramHandle.moduleId >= 0) {
+					slots[i].indicator.process(t, learningId == i);
 				}
 			}
 		}
@@ -396,25 +801,105 @@ struct OscelotModule : Module, OscelotExpanderBase {
 		if (oscResendPeriodically && oscResendDivider.process()) {
 			oscResendFeedback();
 		}
-		// Expander
-		if (rightExpander.module && rightExpander.module->model == modelOscelotExpander && !rightExpander.producerMessage) {
-			rightExpander.producerMessage = new ExpanderPayload((OscelotExpanderBase*)this, 0);
-			rightExpander.requestMessageFlip();
+		if (oscResendRequested.exchange(false)) {
+			const MappingTable* table = mappingTables.get();
+			for (int i = 0; i < table->capacity; i++) {
+				if (table->controllers[i]) {
+					slots[i].oscParam.hasChanged = true;
+					getControllerState(i, table->controllers[i]).resetValueOut();
+				}
+			}
+			cvResend = true;
+		}
+		// Expander, values changed by the engine are passed on right away for sample accurate triggers
+		bool expanderTick = expanderDivider.process();
+		if ((expanderTick || expValuesChanged) && rightExpander.module && isExpander(rightExpander.module->model)) {
+			expValuesChanged = false;
+			expSend();
+		}
+		if (sending && leftExpander.module && leftExpander.module->model == modelOscelotCvExpander) {
+			cvSend();
 		}
 	}
 
+	/** Sends the channels of the CV send expander which changed, all in one bundle, doesn't allocate */
+	void cvSend() {
+		CvMessage* message = CvMessages::getSent(leftExpander.module->rightExpander);
+		if (!message || (message->version == cvVersion && !cvResend)) return;
+		// After a gap, e.g. while sending was off, all channels are sent
+		bool all = cvResend || message->version != cvVersion + 1;
+		cvVersion = message->version;
+		cvResend = false;
+
+		if (!cvChannelAddresses[0][0][0] || std::strncmp(cvAddress, message->address, CvMessage::ADDRESS_LENGTH - 1) != 0) {
+			std::strncpy(cvAddress, message->address, CvMessage::ADDRESS_LENGTH - 1);
+			for (int i = 0; i < CvMessage::NUM_INPUTS; i++) {
+				for (int c = 0; c < 16; c++) {
+					std::snprintf(cvChannelAddresses[i][c], sizeof(cvChannelAddresses[i][c]), "%s/%d/%d", cvAddress, i + 1, c + 1);
+				}
+			}
+		}
+
+		int count = 0;
+		cvStream.Clear();
+		cvStream << osc::BeginBundleImmediate;
+		for (int i = 0; i < CvMessage::NUM_INPUTS; i++) {
+			for (int c = 0; c < std::min(message->channels[i], 16); c++) {
+				if (!all && !(message->changed[i] & (1 << c))) continue;
+				cvStream << osc::BeginMessage(cvChannelAddresses[i][c]) << message->values[i][c] << osc::EndMessage;
+				count++;
+			}
+		}
+		if (count == 0) return;
+		cvStream << osc::EndBundle;
+		oscSender.sendEncodedPacket(cvStream);
+		oscSent = true;
+	}
+
+	/** Passes the values and labels of the first MAX_EXPANDER_SLOTS slots to the expanders when any of them changed */
+	void expSend() {
+		ExpanderMessage* sent = ExpanderMessages::getSent(rightExpander);
+		int n = std::min(slots.size(), MAX_EXPANDER_SLOTS);
+		bool valuesChanged = false;
+		for (int id = 0; id < n && !valuesChanged; id++) valuesChanged = sent->values[id] != slots[id].expValue;
+		uint32_t labelsVersion = expLabelsVersion;
+		if (!valuesChanged && sent->labelsVersion == labelsVersion) return;
+
+		ExpanderMessage* message = ExpanderMessages::getNext(rightExpander);
+		if (message->labelsVersion != labelsVersion) {
+			std::unique_lock<std::mutex> lock(mappingTables.getWriteMutex(), std::try_to_lock);
+			if (lock.owns_lock()) {
+				labelsVersion = expLabelsVersion;
+				for (int id = 0; id < n; id++) ExpanderMessage::setLabel(message->labels[id], slots[id].expLabel);
+				for (int id = n; id < MAX_EXPANDER_SLOTS; id++) ExpanderMessage::setLabel(message->labels[id], "None");
+				message->labelsVersion = labelsVersion;
+			} else if (valuesChanged) {
+				// Labels are being changed right now, they follow on one of the next ticks
+				std::memcpy(message->labels, sent->labels, sizeof(message->labels));
+				message->labelsVersion = sent->labelsVersion;
+			} else {
+				return;
+			}
+		}
+		for (int id = 0; id < n; id++) message->values[id] = slots[id].expValue;
+		for (int id = n; id < MAX_EXPANDER_SLOTS; id++) message->values[id] = -1.0f;
+		message->valuesVersion = sent->valuesVersion + (valuesChanged ? 1 : 0);
+		message->expanderId = 0;
+		rightExpander.requestMessageFlip();
+	}
+
 	std::list<OscArg*> getParamInfo(int id) {
 		std::list<OscArg*> s;
-		if (id >= mapLen) return s;
-		if (paramHandles[id].moduleId < 0) return s;
+		if (id >= getMapLen()) return s;
+		if (slots[id].paramHandle.moduleId < 0) return s;
 
-		ModuleWidget* mw = APP->scene->rack->getModule(paramHandles[id].moduleId);
+		ModuleWidget* mw = APP->scene->rack->getModule(slots[id].paramHandle.moduleId);
 		if (!mw) return s;
 
 		Module* m = mw->getModule();
 		if (!m) return s;
 
-		int paramId = paramHandles[id].paramId;
+		int paramId = slots[id].paramHandle.paramId;
 		if (paramId >= (int)m->params.size()) return s;
 		
 		ParamQuantity* paramQuantity = m->paramQuantities[paramId];
@@ -426,23 +911,26 @@ struct OscelotModule : Module, OscelotExpanderBase {
 		return s;
 	}
 
-	void setMode(OSCMODE oscMode) {
-		if (this->oscMode == oscMode) return;
-		this->oscMode = oscMode;
-		switch (oscMode) {
-		case OSCMODE::OSCMODE_LOCATE:
-			for (int i = 0; i < MAX_PARAMS; i++)
-				if (oscControllers[id]) oscControllers[id]->setValueIndicate(std::fmax(0, oscControllers[i]->getValueIn()));
-			break;
-		default:
-			break;
+	/** Picked up by the engine thread, which owns the values of the controllers */
+	void setMode(OSCMODE oscMode) { this->oscMode = oscMode; }
+
+	/** Only controllers moved after locate mode has been entered are indicated */
+	void startLocate() {
+		const MappingTable* table = mappingTables.get();
+		for (int i = 0; i < table->capacity; i++) {
+			if (!table->controllers[i]) continue;
+			OscControllerState& state = getControllerState(i, table->controllers[i]);
+			state.setValueIndicate(std::fmax(0, state.getValueIn()));
 		}
 	}
 
 	bool processOscMessage(OscMessage msg) {
+		TRACE_ZONE("processOscMessage");
 		std::string address = msg.getAddress();
 		bool oscReceived = false;
 
+		if (oscAutoClients) registerClient(msg);
+
 		// Check for OSC triggers
 		if (address == "/oscelot/next") {
 			oscTriggerNext = true;
@@ -450,123 +938,303 @@ struct OscelotModule : Module, OscelotExpanderBase {
 		} else if (address == "/oscelot/prev") {
 			oscTriggerPrev = true;
 			return oscReceived;
+		} else if (address == "/oscelot/bank") {
+			// Bank number as shown on the panel
+			if (msg.getNumArgs() >= 1) params[PARAM_BANK].setValue(clamp(getArgAsInt(msg, 0) - 1, 0, 127));
+			return oscReceived;
+		} else if (address == "/oscelot/stats") {
+			sendStats(msg);
+			return oscReceived;
+		} else if (address == "/oscelot/stats/reset") {
+			resetStats();
+			return oscReceived;
+		} else if (address == "/oscelot/subscribe") {
+			subscribeClient(msg, true);
+			return oscReceived;
+		} else if (address == "/oscelot/unsubscribe") {
+			subscribeClient(msg, false);
+			return oscReceived;
 		} else if (msg.getNumArgs() < 2) {
+			stats.invalidMessages++;
 			WARN("Discarding OSC message. Need 2 args: id(int) and value(float). OSC message had address: %s and %i args", msg.getAddress().c_str(), (int) msg.getNumArgs());
 			return oscReceived;
+		} else if (!isNumberArg(msg, 0) || !isNumberArg(msg, 1)) {
+			stats.invalidMessages++;
+			return oscReceived;
 		}
 
-		int controllerId = msg.getArgAsInt(0);
-		float value = msg.getArgAsFloat(1);
+		int controllerId = getArgAsInt(msg, 0);
+		float value = getArgAsFloat(msg, 1);
 		// Learn
 		if (learningId >= 0 && (learnedControllerIdLast != controllerId || lastLearnedAddress != address)) {
-			oscControllers[learningId] = OscController::Create(address, controllerId, CONTROLLERMODE::DIRECT, value, ts);
-			expLabels[learningId] = string::f("%s-%02d", oscControllers[learningId]->getTypeString(), oscControllers[learningId]->getControllerId());
-
-			if (oscControllers[learningId]) {
+			// Learned with one of the next messages if the UI is changing the mappings right now
+			std::unique_lock<std::mutex> lock(mappingTables.getWriteMutex(), std::try_to_lock);
+			if (!lock.owns_lock()) return oscReceived;
+			// The new controller and a copy in commitLearn(), the pool and the spare table are refilled by the stager thread
+			if (mappingTables.available() < 2 || !mappingTables.hasSpare()) return oscReceived;
+			OscController* controller = mappingTables.createController(address, controllerId, CONTROLLERMODE::DIRECT);
+
+			if (controller) {
+				controller->initState(slots[learningId].controllerState, value, ts);
+				slots[learningId].expLabel = string::f("%s-%02d", controller->getTypeString(), controller->getControllerId());
+				expLabelsVersion++;
+				MappingTable* table = mappingTables.edit();
+				table->controllers[learningId] = controller;
 				learnedControllerId = true;
 				lastLearnedAddress = address;
 				learnedControllerIdLast = controllerId;
-				commitLearn();
-				updateMapLen();
+				commitLearn(table);
+				updateMapLen(table);
+				mappingTables.publish(table);
 			}
 		} else {
-			for (int id = 0; id < mapLen; id++) {
-				if (oscControllers[id] && (oscControllers[id]->getControllerId() == controllerId && oscControllers[id]->getAddress() == address)) {
+			const MappingTable* table = mappingTables.get();
+			for (int id = 0; id < table->mapLen; id++) {
+				const OscController* controller = table->controllers[id];
+				if (controller && controller->matches(controllerId, address)) {
 					oscReceived = true;
-					oscControllers[id]->setCurrentValue(value, ts);
-					expValues[id] = value;
+					controller->setCurrentValue(getControllerState(id, controller), value, ts);
+					slots[id].expValue = value;
+					expValuesChanged = true;
+					if (slots[id].receiveTime == 0) slots[id].receiveTime = msg.getReceiveTime();
+					if (echoMode != ECHOMODE_OFF) oscSender.setSlotOrigin(id, msg.getRemoteAddress(), msg.getRemotePort());
 
 					return oscReceived;
 				}
 			}
+			stats.unknownAddresses++;
 		}
 		return oscReceived;
 	}
 
-	void oscResendFeedback() {
-		for (int i = 0; i < MAX_PARAMS; i++) {
-			if (oscControllers[i]) {
-				oscParam[i].hasChanged =true;
-				oscControllers[i]->setValueOut("-1");
-			}
-		}
+	/** Feedback of all slots is sent again by the engine thread */
+	void oscResendFeedback() { oscResendRequested = true; }
+
+	int getMapLen() { return mappingTables.get()->mapLen; }
+
+	OscController* getController(int id) { return mappingTables.get()->controllers[id]; }
+
+	/** Published controllers are read by the engine thread, they are changed by replacing them with a copy */
+	void setControllerMode(int id, CONTROLLERMODE mode) {
+		std::lock_guard<std::mutex> lock(mappingTables.getWriteMutex());
+		MappingTable* table = mappingTables.edit();
+		OscController* controller = mappingTables.modifyController(table, id);
+		if (controller) controller->setControllerMode(mode);
+		mappingTables.publish(table);
+	}
+
+	void setControllerSensitivity(int id, int sensitivity) {
+		std::lock_guard<std::mutex> lock(mappingTables.getWriteMutex());
+		MappingTable* table = mappingTables.edit();
+		OscController* controller = mappingTables.modifyController(table, id);
+		if (controller) controller->setSensitivity(sensitivity);
+		mappingTables.publish(table);
 	}
 
 	void clearMap(int id, bool oscOnly = false) {
-		learningId = -1;
-		oscParam[id].reset();
-		oscControllers[id] = nullptr;
-		expValues[id] = 0.0f;
-		if (!oscOnly) {
-			textLabels[id] = "";
-			APP->engine->updateParamHandle(&paramHandles[id], -1, 0, true);
-			updateMapLen();
+		{
+			std::lock_guard<std::mutex> lock(mappingTables.getWriteMutex());
+			learningId = -1;
+			slots[id].oscParam.reset();
+			slots[id].expValue = 0.0f;
+			if (!oscOnly) {
+				slots[id].textLabel = "";
+				mapParamHandle(id, -1, 0, true);
+			}
+			MappingTable* table = mappingTables.edit();
+			table->controllers[id] = nullptr;
+			updateMapLen(table);
+			mappingTables.publish(table);
 		}
+		updateParamHandles();
 	}
 
+	/** Without Lock the caller holds the engine lock, e.g. while loading */
 	void clearMaps(bool Lock = true) {
+		{
+			std::lock_guard<std::mutex> lock(mappingTables.getWriteMutex());
+			applyMappings(std::vector<BankMeowMoryParam>(), false, Lock);
+			meowMoryModuleId = -1;
+		}
+		if (Lock) updateParamHandles();
+	}
+
+	/** Module a slot maps, a change of its param handle might still be pending */
+	int64_t getMappedModuleId(int id) { return slots[id].handlePending ? slots[id].pendingModuleId : slots[id].paramHandle.moduleId; }
+
+	int getMappedParamId(int id) { return slots[id].handlePending ? slots[id].pendingParamId : slots[id].paramHandle.paramId; }
+
+	/** Whether a slot maps another param than the given one, moduleId -1 for none */
+	bool isMappingChanged(int id, int64_t moduleId, int paramId) {
+		int64_t mappedModuleId = getMappedModuleId(id);
+		return moduleId < 0 ? mappedModuleId >= 0 : (mappedModuleId != moduleId || getMappedParamId(id) != paramId);
+	}
+
+	/**
+	 * Maps the param handle of a slot, the caller holds the write mutex. Without Lock the caller
+	 * holds the engine lock as well and the handle is updated right away, otherwise it is left
+	 * pending for updateParamHandles() once the write mutex has been released.
+	 */
+	void mapParamHandle(int id, int64_t moduleId, int paramId, bool Lock) {
+		slots[id].pendingModuleId = moduleId;
+		slots[id].pendingParamId = paramId;
+		if (!Lock) engine->updateParamHandle_NoLock(&slots[id].paramHandle, moduleId, paramId, true);
+		// Updated again if updateParamHandles() might be overwriting it with an older mapping right now
+		slots[id].handlePending = Lock || paramHandlesUpdating;
+	}
+
+	/** Same as mapParamHandle() for all slots marked in changedSlots, with their pending params set */
+	void mapChangedParamHandles(int capacity, bool Lock) {
+		std::vector<uint8_t>& changed = changedSlots;
+		if (!Lock) {
+			// Release changed handles first so a parameter moving to another slot isn't overwritten afterwards
+			for (int id = 0; id < capacity; id++) {
+				if (changed[id] && slots[id].paramHandle.moduleId >= 0) engine->updateParamHandle_NoLock(&slots[id].paramHandle, -1, 0, true);
+			}
+			for (int id = 0; id < capacity; id++) {
+				if (changed[id] && slots[id].pendingModuleId >= 0) engine->updateParamHandle_NoLock(&slots[id].paramHandle, slots[id].pendingModuleId, slots[id].pendingParamId, true);
+			}
+		}
+		for (int id = 0; id < capacity; id++) {
+			if (changed[id]) slots[id].handlePending = Lock || paramHandlesUpdating;
+		}
+	}
+
+	/**
+	 * Applies the param handle changes left pending by writers. Updating a handle locks the
+	 * engine, which in turn waits for the write mutex while a patch is saved or loaded, so this
+	 * is only called after the write mutex has been released and never on the engine thread.
+	 */
+	void updateParamHandles() {
+		std::lock_guard<std::mutex> lock(paramHandleMutex);
+		std::vector<ParamHandleUpdate>& updates = paramHandleUpdates;
+		updates.clear();
+		while (true) {
+			{
+				std::lock_guard<std::mutex> writeLock(mappingTables.getWriteMutex());
+				// Slots changed again meanwhile stay pending
+				for (const ParamHandleUpdate& update : updates) {
+					OscelotSlot& slot = slots[update.id];
+					if (slot.pendingModuleId == update.moduleId && slot.pendingParamId == update.paramId) slot.handlePending = false;
+				}
+				updates.clear();
+				for (int id = 0; id < slots.size(); id++) {
+					if (slots[id].handlePending) updates.push_back({id, slots[id].pendingModuleId, slots[id].pendingParamId});
+				}
+				paramHandlesUpdating = !updates.empty();
+				if (!paramHandlesUpdating) return;
+			}
+			// Same order as mapChangedParamHandles()
+			for (const ParamHandleUpdate& update : updates) {
+				if (slots[update.id].paramHandle.moduleId >= 0) engine->updateParamHandle(&slots[update.id].paramHandle, -1, 0, true);
+			}
+			for (const ParamHandleUpdate& update : updates) {
+				if (update.moduleId >= 0) engine->updateParamHandle(&slots[update.id].paramHandle, update.moduleId, update.paramId, true);
+			}
+		}
+	}
+
+	/**
+	 * Replaces all mapping slots in a single pass: slot i gets mappings[i], slots beyond are
+	 * cleared. Only param handles which actually change are updated and mapLen is computed
+	 * once at the end. With keepOscMappings the OSC controllers of all slots stay untouched.
+	 * The caller holds the write mutex of mappingTables and, with Lock, calls
+	 * updateParamHandles() after releasing it.
+	 */
+	void applyMappings(const std::vector<BankMeowMoryParam>& mappings, bool keepOscMappings, bool Lock = true) {
 		learningId = -1;
-		for (int id = 0; id < MAX_PARAMS; id++) {
-			textLabels[id] = "";
-			oscParam[id].reset();
-			oscControllers[id] = nullptr;
-			expValues[id] = 0.0f;
-			if(Lock){
-				APP->engine->updateParamHandle(&paramHandles[id], -1, 0, true);
-			} else {
-				APP->engine->updateParamHandle_NoLock(&paramHandles[id], -1, 0, true);
+		MappingTable* table = mappingTables.edit();
+		int capacity = table->capacity;
+		// Mappings which don't fit are applied again once the stager thread has grown the slots
+		reapplyMappings = (int)mappings.size() > capacity;
+		if (reapplyMappings) {
+			pendingMappings = mappings;
+			pendingKeepOscMappings = keepOscMappings;
+			requestSlots(mappings.size() + 1);
+		}
+		std::vector<uint8_t>& changed = changedSlots;
+		for (int id = 0; id < capacity; id++) {
+			const BankMeowMoryParam* mapping = id < (int)mappings.size() ? &mappings[id] : nullptr;
+			int64_t moduleId = mapping ? mapping->moduleId : -1;
+			int paramId = moduleId >= 0 ? mapping->paramId : 0;
+			slots[id].textLabel = mapping ? mapping->label : "";
+			slots[id].oscParam.reset();
+			changed[id] = isMappingChanged(id, moduleId, paramId);
+			if (changed[id]) {
+				slots[id].pendingModuleId = moduleId;
+				slots[id].pendingParamId = paramId;
+			}
+
+			if (keepOscMappings) continue;
+			table->controllers[id] = nullptr;
+			slots[id].expValue = 0.0f;
+			slots[id].expLabel = "None";
+			if (mapping && mapping->controllerId >= 0) {
+				OscController* controller = mappingTables.createController(mapping->address, mapping->controllerId, mapping->controllerMode);
+				if (!controller) continue;
+				table->controllers[id] = controller;
+				slots[id].expLabel = string::f("%s-%02d", controller->getTypeString(), controller->getControllerId());
+				if (mapping->encSensitivity) controller->setSensitivity(mapping->encSensitivity);
 			}
 		}
-		mapLen = 1;
-		meowMoryModuleId = -1;
+
+		mapChangedParamHandles(capacity, Lock);
+		updateMapLen(table);
+		mappingTables.publish(table);
+		if (!keepOscMappings) expLabelsVersion++;
 	}
 
-	void updateMapLen() {
+	void updateMapLen(MappingTable* table) {
 		// Find last nonempty map
 		int id;
-		for (id = MAX_PARAMS - 1; id >= 0; id--) {
-			if (paramHandles[id].moduleId >= 0 || oscControllers[id]) break;
+		for (id = table->capacity - 1; id >= 0; id--) {
+			if (getMappedModuleId(id) >= 0 || table->controllers[id]) break;
 		}
-		mapLen = id + 1;
+		table->mapLen = id + 1;
 		// Add an empty "Mapping..." slot
-		if (mapLen < MAX_PARAMS) {
-			mapLen++;
+		if (table->mapLen < table->capacity) {
+			table->mapLen++;
 		}
+		// Another block before the empty slot runs out
+		if (table->mapLen == table->capacity) requestSlots(table->capacity + 1);
 	}
 
-	void commitLearn() {
+	void commitLearn(MappingTable* table) {
 		if (learningId < 0) return;
 		if (!learnedControllerId) return;
 		// Reset learned state
 		learnedControllerId = false;
 		learnedParam = false;
 		// Copy mode and sensitivity from the previous slot
-		if (learningId > 0 && oscControllers[learningId - 1]) {
-			if (oscControllers[learningId - 1]->getSensitivity() != OscController::ENCODER_DEFAULT_SENSITIVITY) {
-				oscControllers[learningId]->setSensitivity(oscControllers[learningId - 1]->getSensitivity());
+		OscController* previous = learningId > 0 ? table->controllers[learningId - 1] : nullptr;
+		OscController* controller = previous ? mappingTables.modifyController(table, learningId) : nullptr;
+		if (controller) {
+			if (previous->getSensitivity() != OscController::ENCODER_DEFAULT_SENSITIVITY) {
+				controller->setSensitivity(previous->getSensitivity());
 			}
-			oscControllers[learningId]->setControllerMode(oscControllers[learningId - 1]->getControllerMode());
+			controller->setControllerMode(previous->getControllerMode());
 		}
 
 		// Find next incomplete map
-		while (!learnSingleSlot && ++learningId < MAX_PARAMS) {
-			if (!oscControllers[learningId] || paramHandles[learningId].moduleId < 0) return;
+		while (!learnSingleSlot && ++learningId < table->capacity) {
+			if (!table->controllers[learningId] || getMappedModuleId(learningId) < 0) return;
 		}
 		learningId = -1;
 	}
 
 	int enableLearn(int id, bool learnSingle = false) {
+		const MappingTable* table = mappingTables.get();
 		if (id == -1) {
 			// Find next incomplete map
-			while (++id < MAX_PARAMS) {
-				if (!oscControllers[id] && paramHandles[id].moduleId < 0) break;
+			while (++id < table->capacity) {
+				if (!table->controllers[id] && slots[id].paramHandle.moduleId < 0) break;
 			}
-			if (id == MAX_PARAMS) {
+			if (id == table->capacity) {
 				return -1;
 			}
 		}
 
-		if (id == mapLen) {
+		if (id == table->mapLen) {
 			disableLearn();
 			return -1;
 		}
@@ -590,97 +1258,89 @@ struct OscelotModule : Module, OscelotExpanderBase {
 	}
 
 	void learnParam(int id, int64_t moduleId, int paramId, bool Lock = true) {
-		if(Lock){
-			APP->engine->updateParamHandle(&paramHandles[id], moduleId, paramId, true);
-		} else {
-			APP->engine->updateParamHandle_NoLock(&paramHandles[id], moduleId, paramId, true);
+		{
+			std::lock_guard<std::mutex> lock(mappingTables.getWriteMutex());
+			mapParamHandle(id, moduleId, paramId, Lock);
+			slots[id].textLabel = "";
+			slots[id].oscParam.reset();
+			learnedParam = true;
+			MappingTable* table = mappingTables.edit();
+			commitLearn(table);
+			updateMapLen(table);
+			mappingTables.publish(table);
 		}
-		textLabels[id] = "";
-		oscParam[id].reset();
-		learnedParam = true;
-		commitLearn();
-		updateMapLen();
-	}
-
-	void learnMapping(int mapId, ModuleMeowMoryParam meowMoryParam) {
-		if (meowMoryParam.controllerId >= 0) {
-			oscControllers[mapId] = OscController::Create(meowMoryParam.address, meowMoryParam.controllerId, meowMoryParam.controllerMode);
-			expLabels[mapId] = string::f("%s-%02d", oscControllers[mapId]->getTypeString(), oscControllers[mapId]->getControllerId());
-			if (meowMoryParam.encSensitivity) oscControllers[mapId]->setSensitivity(meowMoryParam.encSensitivity);
-		}
-		textLabels[mapId] = meowMoryParam.label;
+		if (Lock) updateParamHandles();
 	}
 
 	void moduleBind(Module* m, bool keepOscMappings) {
 		if (!m) return;
-		if (!keepOscMappings) {
-			clearMaps();
-		} else {
-			// Clean up some additional mappings on the end
-			for (int i = int(m->params.size()); i < mapLen; i++) {
-				textLabels[i] = "";
-				APP->engine->updateParamHandle(&paramHandles[i], -1, -1, true);
-			}
+		growSlots(m->params.size() + 1);
+		std::vector<BankMeowMoryParam> mappings(m->params.size());
+		for (size_t i = 0; i < mappings.size(); i++) {
+			mappings[i].moduleId = m->id;
+			mappings[i].paramId = int(i);
 		}
-		for (size_t i = 0; i < m->params.size() && i < MAX_PARAMS; i++) {
-			learnParam(int(i), m->id, int(i));
+		{
+			std::lock_guard<std::mutex> lock(mappingTables.getWriteMutex());
+			applyMappings(mappings, keepOscMappings);
+			if (!keepOscMappings) meowMoryModuleId = -1;
 		}
-
-		updateMapLen();
+		updateParamHandles();
 	}
 
 	void moduleMeowMorySave(std::string saveKey) {
 		ModuleMeowMory meowMory = ModuleMeowMory();
 		Module* module = NULL;
-		for (int mapIndex = 0; mapIndex < mapLen; mapIndex++) {
-			if (paramHandles[mapIndex].moduleId < 0) continue;
+		const MappingTable* table = mappingTables.get();
+		for (int mapIndex = 0; mapIndex < table->mapLen; mapIndex++) {
+			if (slots[mapIndex].paramHandle.moduleId < 0) continue;
 
-			auto paramKey = string::f("%s %s", paramHandles[mapIndex].module->model->plugin->slug.c_str(), paramHandles[mapIndex].module->model->slug.c_str());
+			auto paramKey = string::f("%s %s", slots[mapIndex].paramHandle.module->model->plugin->slug.c_str(), slots[mapIndex].paramHandle.module->model->slug.c_str());
 			if (paramKey != saveKey) continue;
-			module = paramHandles[mapIndex].module;
+			module = slots[mapIndex].paramHandle.module;
 
 			ModuleMeowMoryParam meowMoryParam = ModuleMeowMoryParam();
-			meowMoryParam.fromMappings(paramHandles[mapIndex], oscControllers[mapIndex], textLabels[mapIndex]);
+			meowMoryParam.fromMappings(slots[mapIndex].paramHandle, table->controllers[mapIndex], slots[mapIndex].textLabel);
 			meowMory.paramArray.push_back(meowMoryParam);
 		}
 		meowMory.pluginName = module->model->plugin->name;
 		meowMory.moduleName = module->model->name;
 		meowMoryStorage[saveKey] = meowMory;
+		meowMoryIndex.invalidate();
 	}
 
-	void moduleMeowMoryDelete(std::string key) { meowMoryStorage.erase(key); }
+	void moduleMeowMoryDelete(std::string key) {
+		meowMoryStorage.erase(key);
+		meowMoryIndex.invalidate();
+	}
 
 	void moduleMeowMoryApply(Module* m) {
+		TRACE_ZONE("moduleMeowMoryApply");
 		if (!m) return;
-		auto key = string::f("%s %s", m->model->plugin->slug.c_str(), m->model->slug.c_str());
-		auto it = meowMoryStorage.find(key);
-		if (it == meowMoryStorage.end()) return;
-		ModuleMeowMory meowMory = it->second;
-
-		clearMaps();
-		meowMoryModuleId = m->id;
-		int mapIndex = 0;
-		for (ModuleMeowMoryParam meowMoryParam : meowMory.paramArray) {
-			learnParam(mapIndex, m->id, meowMoryParam.paramId);
-			learnMapping(mapIndex, meowMoryParam);
-			mapIndex++;
+		std::vector<BankMeowMoryParam>* plan = meowMoryIndex.find(meowMoryStorage, m->model);
+		if (!plan) return;
+		growSlots(plan->size() + 1);
+		ModuleMeowMoryIndex::bind(*plan, m->id);
+		{
+			std::lock_guard<std::mutex> lock(mappingTables.getWriteMutex());
+			applyMappings(*plan, false);
+			meowMoryModuleId = m->id;
 		}
-		updateMapLen();
+		updateParamHandles();
 	}
 
 	bool moduleMeowMoryTest(Module* m) {
 		if (!m) return false;
-		auto key = string::f("%s %s", m->model->plugin->slug.c_str(), m->model->slug.c_str());
-		auto it = meowMoryStorage.find(key);
-		if (it == meowMoryStorage.end()) return false;
-		return true;
+		return meowMoryIndex.find(meowMoryStorage, m->model) != nullptr;
 	}
 
+	/** Callers hold bankStager's mutex while writing or reading the bank storage */
 	void bankMeowMorySave(int index) { 
 		BankMeowMory meowMory;
-		for (int id = 0; id < mapLen; id++) {
+		const MappingTable* table = mappingTables.get();
+		for (int id = 0; id < table->mapLen; id++) {
 			BankMeowMoryParam param;
-			param.fromMappings(paramHandles[id], oscControllers[id], textLabels[id]);
+			param.fromMappings(slots[id].paramHandle, table->controllers[id], slots[id].textLabel);
 			meowMory.bankParamArray.push_back(param);
 		}
 		meowMoryBankStorage[index] = meowMory;
@@ -688,15 +1348,69 @@ struct OscelotModule : Module, OscelotExpanderBase {
 
 	void bankMeowMoryDelete(int index) { meowMoryBankStorage[index] = BankMeowMory(); }
 
+	/** The caller holds the write mutex of mappingTables */
 	void bankMeowMoryApply(int index) {
-		clearMaps(false);
-		int mapIndex = 0;
-		for (BankMeowMoryParam meowMoryParam : meowMoryBankStorage[index].bankParamArray) {
-			learnParam(mapIndex, meowMoryParam.moduleId, meowMoryParam.paramId, false);
-			learnMapping(mapIndex, meowMoryParam);
-			mapIndex++;
+		TRACE_ZONE("bankMeowMoryApply");
+		const std::list<BankMeowMoryParam>& bankParamArray = meowMoryBankStorage[index].bankParamArray;
+		applyMappings(std::vector<BankMeowMoryParam>(bankParamArray.begin(), bankParamArray.end()), false, false);
+		meowMoryModuleId = -1;
+	}
+
+	/** Switches banks by swapping in the pre-staged table, neither blocks nor allocates */
+	void bankSwitch(int index) {
+		TRACE_ZONE("bankSwitch");
+		// Switched on one of the next samples if the UI is changing the mappings right now
+		std::unique_lock<std::mutex> writeLock(mappingTables.getWriteMutex(), std::try_to_lock);
+		if (!writeLock.owns_lock()) return;
+		// The controllers of the bank come from the pool and the table is the spare one, both refilled by the stager thread
+		if (mappingTables.available() < mappingTables.getCapacity() || !mappingTables.hasSpare()) return;
+		// Also retried until the stager has staged the bank again after its storage or the slots changed
+		StagedBank* bank = bankStager.take(index, mappingTables.getCapacity());
+		if (!bank) return;
+		bankSwap(bank);
+		bankStager.retire(bank, currentBankIndex);
+		currentBankIndex = index;
+		bankStager.setActiveBank(index);
+	}
+
+	/**
+	 * Exchanges all slots with a staged table, afterwards the table holds the slots of the bank
+	 * left. Controllers are copied from and to the pool, param handles are updated for changed
+	 * slots only.
+	 */
+	void bankSwap(StagedBank* bank) {
+		learningId = -1;
+		MappingTable* table = mappingTables.edit();
+		int capacity = table->capacity;
+		std::vector<uint8_t>& changed = changedSlots;
+		for (int id = 0; id < capacity; id++) {
+			int64_t moduleId = bank->moduleIds[id];
+			int paramId = bank->paramIds[id];
+			changed[id] = isMappingChanged(id, moduleId, paramId);
+			bank->moduleIds[id] = getMappedModuleId(id);
+			bank->paramIds[id] = getMappedParamId(id);
+			if (changed[id]) {
+				slots[id].pendingModuleId = moduleId;
+				slots[id].pendingParamId = paramId;
+			}
+
+			OscController* previous = table->controllers[id];
+			// New serials, the values of the controllers start over
+			table->controllers[id] = bank->hasController[id] ? mappingTables.copyController(bank->controllers[id]) : nullptr;
+			bank->hasController[id] = previous != nullptr;
+			if (previous) bank->controllers[id] = *previous;
+			std::swap(slots[id].textLabel, bank->labels[id]);
+			std::swap(slots[id].expLabel, bank->expLabels[id]);
+			slots[id].oscParam.reset();
+			slots[id].expValue = 0.0f;
+			slots[id].receiveTime = 0;
 		}
-		updateMapLen();
+
+		mapChangedParamHandles(capacity, false);
+		updateMapLen(table);
+		mappingTables.publish(table);
+		expLabelsVersion++;
+		meowMoryModuleId = -1;
 	}
 
 	void setProcessDivision(int d) {
@@ -707,14 +1421,6 @@ struct OscelotModule : Module, OscelotExpanderBase {
 		lightDivider.reset();
 	}
 
-	float* expGetValues() override {
-		return expValues;
-	}
-	
-	std::string* expGetLabels() override {
-		return expLabels;
-	}
-
 	json_t* dataToJson() override {
 		json_t* rootJ = json_object();
 
@@ -734,7 +1440,26 @@ struct OscelotModule : Module, OscelotExpanderBase {
 		json_object_set_new(rootJ, "oscResendPeriodically", json_boolean(oscResendPeriodically));
 		json_object_set_new(rootJ, "alwaysSendFullFeedback", json_boolean(alwaysSendFullFeedback));
 		json_object_set_new(rootJ, "oscIgnoreDevices", json_boolean(oscIgnoreDevices));
-		json_object_set_new(rootJ, "currentBankIndex", json_integer(currentBankIndex));
+		json_object_set_new(rootJ, "oscAutoClients", json_boolean(oscAutoClients));
+		json_object_set_new(rootJ, "autoClientReplyPort", json_integer(autoClientReplyPort));
+		json_object_set_new(rootJ, "autoClientTimeout", json_integer(autoClientTimeout));
+		json_object_set_new(rootJ, "feedbackPacketRate", json_integer(feedbackPacketRate));
+		json_object_set_new(rootJ, "feedbackByteRate", json_integer(feedbackByteRate));
+		json_object_set_new(rootJ, "echoMode", json_integer(echoMode));
+		json_object_set_new(rootJ, "echoHoldTime", json_integer(echoHoldTime));
+		json_object_set_new(rootJ, "echoMatchPort", json_boolean(echoMatchPort));
+
+		// Additional feedback destinations
+		json_t* destinationsJ = json_array();
+		for (OscDestination& destination : oscSender.getDestinations()) {
+			if (destination.primary) continue;
+			json_t* destinationJ = json_object();
+			json_object_set_new(destinationJ, "host", json_string(destination.host.c_str()));
+			json_object_set_new(destinationJ, "port", json_integer(destination.port));
+			json_object_set_new(destinationJ, "enabled", json_boolean(destination.enabled));
+			json_array_append_new(destinationsJ, destinationJ);
+		}
+		json_object_set_new(rootJ, "destinations", destinationsJ);
 
 		// Module MeowMory
 		json_t* meowMoryStorageJ = json_array();
@@ -747,7 +1472,18 @@ struct OscelotModule : Module, OscelotExpanderBase {
 		json_object_set_new(rootJ, "meowMory", meowMoryStorageJ);
 
 		// Bank MeowMory
-		bankMeowMorySave(currentBankIndex);
+		int savedBankIndex;
+		{
+			// The engine only try-locks the write mutex, so it doesn't switch banks or change slots meanwhile
+			std::lock_guard<std::mutex> writeLock(mappingTables.getWriteMutex());
+			bankStager.flushRetired();
+			savedBankIndex = currentBankIndex;
+			std::lock_guard<std::mutex> lock(bankStager.getMutex());
+			bankMeowMorySave(savedBankIndex);
+			bankStager.invalidate(savedBankIndex);
+		}
+		json_object_set_new(rootJ, "currentBankIndex", json_integer(savedBankIndex));
+		std::lock_guard<std::mutex> lock(bankStager.getMutex());
 		json_t* meowMoryBankStorageJ = json_array();
 		for (int bankIndex = 0; bankIndex < 128; bankIndex++) {
 			if (meowMoryBankStorage[bankIndex].bankParamArray.size() == 0) continue;
@@ -774,6 +1510,9 @@ struct OscelotModule : Module, OscelotExpanderBase {
 		locked = json_boolean_value(json_object_get(rootJ, "locked"));
 		processDivision = json_integer_value(json_object_get(rootJ, "processDivision"));
 		clearMapsOnLoad = json_boolean_value(json_object_get(rootJ, "clearMapsOnLoad"));
+		setFeedbackRateLimit(json_integer_value(json_object_get(rootJ, "feedbackPacketRate")), json_integer_value(json_object_get(rootJ, "feedbackByteRate")));
+		json_t* echoHoldTimeJ = json_object_get(rootJ, "echoHoldTime");
+		setEchoSuppression((ECHOMODE)json_integer_value(json_object_get(rootJ, "echoMode")), echoHoldTimeJ ? json_integer_value(echoHoldTimeJ) : 250, json_boolean_value(json_object_get(rootJ, "echoMatchPort")));
 		if (clearMapsOnLoad) clearMaps(false);
 
 		// Module MeowMory
@@ -787,11 +1526,13 @@ struct OscelotModule : Module, OscelotExpanderBase {
 			meowMory.fromJson(meowMoryJ);
 			meowMoryStorage[key] = meowMory;
 		}
+		meowMoryIndex.invalidate();
 
 		// Bank MeowMory
 		json_t* banksJ = json_object_get(rootJ, "banks");
 		json_t* currentBankIndexJ = json_object_get(rootJ, "currentBankIndex");
 		currentBankIndex = currentBankIndexJ ? json_integer_value(currentBankIndexJ) : 0;
+		std::unique_lock<std::mutex> lock(bankStager.getMutex());
 		if (banksJ) {
 			size_t bankArrayIndex;
 			json_t* bankObjectJ;
@@ -800,9 +1541,17 @@ struct OscelotModule : Module, OscelotExpanderBase {
 				BankMeowMory meowMory;
 				meowMory.fromJson(bankObjectJ);
 				meowMoryBankStorage[bankIndex] = meowMory;
+				// Banks larger than the slots are staged once the stager thread has grown them
+				requestSlots(meowMory.bankParamArray.size() + 1);
 			}
 		}
-		bankMeowMoryApply(currentBankIndex);
+		bankStager.invalidateAll();
+		bankStager.setActiveBank(currentBankIndex);
+		lock.unlock();
+		{
+			std::lock_guard<std::mutex> writeLock(mappingTables.getWriteMutex());
+			bankMeowMoryApply(currentBankIndex);
+		}
 
 		// OSC settings
 		if (!oscIgnoreDevices) {
@@ -812,29 +1561,48 @@ struct OscelotModule : Module, OscelotExpanderBase {
 			ip = json_string_value(json_object_get(rootJ, "ip"));
 			txPort = json_string_value(json_object_get(rootJ, "txPort"));
 			rxPort = json_string_value(json_object_get(rootJ, "rxPort"));
+
+			setAutoClients(json_boolean_value(json_object_get(rootJ, "oscAutoClients")));
+			autoClientReplyPort = (AUTOCLIENT_REPLYPORT)json_integer_value(json_object_get(rootJ, "autoClientReplyPort"));
+			json_t* autoClientTimeoutJ = json_object_get(rootJ, "autoClientTimeout");
+			if (autoClientTimeoutJ) autoClientTimeout = json_integer_value(autoClientTimeoutJ);
+
+			oscSender.clearDestinations();
+			json_t* destinationsJ = json_object_get(rootJ, "destinations");
+			size_t destinationIndex;
+			json_t* destinationJ;
+			json_array_foreach(destinationsJ, destinationIndex, destinationJ) {
+				std::string host = json_string_value(json_object_get(destinationJ, "host"));
+				int port = json_integer_value(json_object_get(destinationJ, "port"));
+				bool enabled = json_boolean_value(json_object_get(destinationJ, "enabled"));
+				addDestination(host, port, enabled);
+			}
 			receiverPower();
 			senderPower();
 		}
 	}
 };
 
-struct OscelotChoice : MapModuleChoice<MAX_PARAMS, OscelotModule> {
+struct OscelotChoice : MapModuleChoice<OscelotModule> {
 	OscelotChoice() {
 		textOffset = Vec(6.f, 14.7f);
 		color = nvgRGB(0xfe, 0xff, 0xe0);
 	}
 
 	std::string getSlotPrefix() override {
-		if (module->oscControllers[id]) {
-			return string::f("%s-%02d | ", module->oscControllers[id]->getTypeString(), module->oscControllers[id]->getControllerId());
-		} else if (module->paramHandles[id].moduleId >= 0) {
+		OscController* controller = module->getController(id);
+		if (controller) {
+			return string::f("%s-%02d | ", controller->getTypeString(), controller->getControllerId());
+		} else if (module->slots[id].paramHandle.moduleId >= 0) {
 			return ".... ";
 		} else {
 			return "";
 		}
 	}
 
-	std::string getSlotLabel() override { return module->textLabels[id]; }
+	std::string getSlotLabel() override { return module->slots[id].textLabel; }
+
+	uint64_t getSlotVersion() override { return module->mappingTables.get()->version; }
 
 	void appendContextMenu(Menu* menu) override {
 		struct EncoderMenuItem : MenuItem {
@@ -847,7 +1615,7 @@ struct OscelotChoice : MapModuleChoice<MAX_PARAMS, OscelotModule> {
 				int id;
 				void onSelectKey(const event::SelectKey& e) override {
 					if (e.action == GLFW_PRESS && e.key == GLFW_KEY_ENTER) {
-						module->oscControllers[id]->setSensitivity(std::stoi(text));
+						module->setControllerSensitivity(id, std::stoi(text));
 
 						ui::MenuOverlay* overlay = getAncestorOfType<ui::MenuOverlay>();
 						overlay->requestDelete();
@@ -866,26 +1634,37 @@ struct OscelotChoice : MapModuleChoice<MAX_PARAMS, OscelotModule> {
 				LabelField* labelField = new LabelField;
 				labelField->box.size.x = 60;
 				labelField->module = module;
-				labelField->text = std::to_string(module->oscControllers[id]->getSensitivity());
+				OscController* controller = module->getController(id);
+				labelField->text = std::to_string(controller ? controller->getSensitivity() : OscController::ENCODER_DEFAULT_SENSITIVITY);
 				labelField->id = id;
 				menu->addChild(labelField);
-				menu->addChild(createMenuItem("Reset", "", [=]() { module->oscControllers[id]->setSensitivity(OscController::ENCODER_DEFAULT_SENSITIVITY); }));
+				menu->addChild(createMenuItem("Reset", "", [=]() {
+					module->setControllerSensitivity(id, OscController::ENCODER_DEFAULT_SENSITIVITY);
+				}));
 
 				return menu;
 			}
 		};  // struct EncoderMenuItem
 
-		if (module->oscControllers[id]) {
+		OscController* controller = module->getController(id);
+		if (controller) {
 			menu->addChild(createMenuItem("Clear OSC assignment", "", [=]() { module->clearMap(id, true); }));
-			if (strcmp(module->oscControllers[id]->getTypeString(), "ENC") == 0)
+			if (strcmp(controller->getTypeString(), "ENC") == 0)
 				menu->addChild(construct<EncoderMenuItem>(&MenuItem::text, "Encoder Sensitivity", &EncoderMenuItem::module, module, &EncoderMenuItem::id, id));
 			else
 				menu->addChild(createSubmenuItem("Input mode for Controller", "", [=](Menu* menu) {
-					menu->addChild(createCheckMenuItem("Direct", "", [=]() { return module->oscControllers[id]->getControllerMode() == CONTROLLERMODE::DIRECT; }, [=]() { module->oscControllers[id]->setControllerMode(CONTROLLERMODE::DIRECT); }));
-					menu->addChild(createCheckMenuItem("Pickup (snap)", "", [=]() { return module->oscControllers[id]->getControllerMode() == CONTROLLERMODE::PICKUP1; }, [=]() { module->oscControllers[id]->setControllerMode(CONTROLLERMODE::PICKUP1); }));
-					menu->addChild(createCheckMenuItem("Pickup (jump)", "", [=]() { return module->oscControllers[id]->getControllerMode() == CONTROLLERMODE::PICKUP2; }, [=]() { module->oscControllers[id]->setControllerMode(CONTROLLERMODE::PICKUP2); }));
-					menu->addChild(createCheckMenuItem("Toggle", "", [=]() { return module->oscControllers[id]->getControllerMode() == CONTROLLERMODE::TOGGLE; }, [=]() { module->oscControllers[id]->setControllerMode(CONTROLLERMODE::TOGGLE); }));
-					menu->addChild(createCheckMenuItem("Toggle + Value", "", [=]() { return module->oscControllers[id]->getControllerMode() == CONTROLLERMODE::TOGGLE_VALUE; }, [=]() { module->oscControllers[id]->setControllerMode(CONTROLLERMODE::TOGGLE_VALUE); }));
+					// The controller of the slot may have been replaced since the menu was opened
+					auto addModeItem = [=](std::string text, CONTROLLERMODE mode) {
+						menu->addChild(createCheckMenuItem(text, "", [=]() {
+							OscController* controller = module->getController(id);
+							return controller && controller->getControllerMode() == mode;
+						}, [=]() { module->setControllerMode(id, mode); }));
+					};
+					addModeItem("Direct", CONTROLLERMODE::DIRECT);
+					addModeItem("Pickup (snap)", CONTROLLERMODE::PICKUP1);
+					addModeItem("Pickup (jump)", CONTROLLERMODE::PICKUP2);
+					addModeItem("Toggle", CONTROLLERMODE::TOGGLE);
+					addModeItem("Toggle + Value", CONTROLLERMODE::TOGGLE_VALUE);
 				}));
 		}
 	}
@@ -950,17 +1729,7 @@ struct OscWidget : widget::OpaqueWidget {
 	}
 };
 
-struct OscelotDisplay : MapModuleDisplay<MAX_PARAMS, OscelotModule, OscelotChoice> {
-	void step() override {
-		if (module) {
-			int mapLen = module->mapLen;
-			for (int id = 0; id < MAX_PARAMS; id++) {
-				choices[id]->visible = (id < mapLen);
-			}
-		}
-		MapModuleDisplay<MAX_PARAMS, OscelotModule, OscelotChoice>::step();
-	}
-};
+struct OscelotDisplay : MapModuleDisplay<OscelotModule, OscelotChoice> {};
 
 struct OscelotWidget : ThemedModuleWidget<OscelotModule>, ParamWidgetContextExtender {
 	OscelotModule* module;
@@ -972,6 +1741,9 @@ struct OscelotWidget : ThemedModuleWidget<OscelotModule>, ParamWidgetContextExte
 	dsp::SchmittTrigger meowMoryPrevTrigger;
 	dsp::SchmittTrigger meowMoryNextTrigger;
 	dsp::SchmittTrigger meowMoryParamTrigger;
+	/** Modules with stored mappings for PREV/NEXT */
+	ModuleOrder meowMoryOrder;
+	uint32_t meowMoryOrderVersion = 0;
 
 	std::string contextLabel = "";
 
@@ -1034,6 +1806,7 @@ struct OscelotWidget : ThemedModuleWidget<OscelotModule>, ParamWidgetContextExte
 		slider->module = module;
 		if (module) {
 			slider->label->text = std::to_string(module->currentBankIndex + 1);
+			module->mappingTables.setOnline(MappingTables::READER_UI, true);
 		}
 		addChild(slider);
 	}
@@ -1042,9 +1815,12 @@ struct OscelotWidget : ThemedModuleWidget<OscelotModule>, ParamWidgetContextExte
 		if (learnMode != LEARN_MODE::OFF) {
 			glfwSetCursor(APP->window->win, NULL);
 		}
+		if (module) module->mappingTables.setOnline(MappingTables::READER_UI, false);
 	}
 
 	void step() override {
+		// Pointers from the mapping table are only used within a frame
+		if (module) module->mappingTables.quiescent(MappingTables::READER_UI);
 		ThemedModuleWidget<OscelotModule>::step();
 		if (module) {
 			if (receiveTrigger.process(module->params[OscelotModule::PARAM_RECV].getValue() > 0.0f)) {
@@ -1057,6 +1833,7 @@ struct OscelotWidget : ThemedModuleWidget<OscelotModule>, ParamWidgetContextExte
 				module->senderPower();
 			}
 
+			meowMoryOrder.check(APP->scene->rack->getModuleContainer()->children);
 			if (module->oscTriggerPrev || meowMoryPrevTrigger.process(module->params[OscelotModule::PARAM_PREV].getValue())) {
 				module->oscTriggerPrev = false;
 				meowMoryPrevModule();
@@ -1086,59 +1863,19 @@ struct OscelotWidget : ThemedModuleWidget<OscelotModule>, ParamWidgetContextExte
 	}
 
 	void meowMoryPrevModule() {
-		std::list<Widget*> modules = APP->scene->rack->getModuleContainer()->children;
-		auto sort = [&](Widget* w1, Widget* w2) {
-			auto t1 = std::make_tuple(w1->box.pos.y, w1->box.pos.x);
-			auto t2 = std::make_tuple(w2->box.pos.y, w2->box.pos.x);
-			return t1 > t2;
-		};
-		modules.sort(sort);
-		meowMoryScanModules(modules);
+		module->moduleMeowMoryApply(getMeowMoryOrder().prev(module->meowMoryModuleId));
 	}
 
 	void meowMoryNextModule() {
-		std::list<Widget*> modules = APP->scene->rack->getModuleContainer()->children;
-		auto sort = [&](Widget* w1, Widget* w2) {
-			auto t1 = std::make_tuple(w1->box.pos.y, w1->box.pos.x);
-			auto t2 = std::make_tuple(w2->box.pos.y, w2->box.pos.x);
-			return t1 < t2;
-		};
-		modules.sort(sort);
-		meowMoryScanModules(modules);
-	}
-
-	void meowMoryScanModules(std::list<Widget*>& modules) {
-	f:
-		std::list<Widget*>::iterator it = modules.begin();
-		// Scan for current module in the list
-		if (module->meowMoryModuleId != -1) {
-			for (; it != modules.end(); it++) {
-				ModuleWidget* mw = dynamic_cast<ModuleWidget*>(*it);
-				Module* m = mw->module;
-				if (m->id == module->meowMoryModuleId) {
-					it++;
-					break;
-				}
-			}
-			// Module not found
-			if (it == modules.end()) {
-				it = modules.begin();
-			}
-		}
-		// Scan for next module with stored mapping
-		for (; it != modules.end(); it++) {
-			ModuleWidget* mw = dynamic_cast<ModuleWidget*>(*it);
-			Module* m = mw->module;
-			if (module->moduleMeowMoryTest(m)) {
-				module->moduleMeowMoryApply(m);
-				return;
-			}
-		}
-		// No module found yet -> retry from the beginning
-		if (module->meowMoryModuleId != -1) {
-			module->meowMoryModuleId = -1;
-			goto f;
+		module->moduleMeowMoryApply(getMeowMoryOrder().next(module->meowMoryModuleId));
+	}
+
+	ModuleOrder& getMeowMoryOrder() {
+		if (!meowMoryOrder.isValid() || meowMoryOrderVersion != module->meowMoryIndex.getVersion()) {
+			meowMoryOrderVersion = module->meowMoryIndex.getVersion();
+			meowMoryOrder.rebuild(APP->scene->rack->getModuleContainer()->children, [this](Module* m) { return module->moduleMeowMoryTest(m); });
 		}
+		return meowMoryOrder;
 	}
 
 	void extendParamWidgetContextMenu(ParamWidget* pw, Menu* menu) override {
@@ -1173,15 +1910,16 @@ struct OscelotWidget : ThemedModuleWidget<OscelotModule>, ParamWidgetContextExte
 					menu->addChild(createMenuItem("Learn OSC", "", [=]() { module->enableLearn(currentId, true); }));
 				}
 
-				if (module->mapLen > 0) {
+				const MappingTable* table = module->mappingTables.get();
+				if (table->mapLen > 0) {
 					menu->addChild(new MenuSeparator);
-					for (int id = 0; id < module->mapLen; id++) {
-						if (module->oscControllers[id]) {
+					for (int id = 0; id < table->mapLen; id++) {
+						if (table->controllers[id]) {
 							std::string text;
-							if (module->textLabels[id] != "") {
-								text = module->textLabels[id];
+							if (module->slots[id].textLabel != "") {
+								text = module->slots[id].textLabel;
 							} else {
-								text = string::f("%s-%02d", module->oscControllers[id]->getTypeString(), module->oscControllers[id]->getControllerId());
+								text = string::f("%s-%02d", table->controllers[id]->getTypeString(), table->controllers[id]->getControllerId());
 							}
 							menu->addChild(createCheckMenuItem(text, "", [=]() { return id == currentId; }, [=]() { module->learnParam(id, pq->module->id, pq->paramId); }));
 						}
@@ -1212,8 +1950,9 @@ struct OscelotWidget : ThemedModuleWidget<OscelotModule>, ParamWidgetContextExte
 			}
 		}
 
-		for (int id = 0; id < module->mapLen; id++) {
-			if (module->paramHandles[id].moduleId == pq->module->id && module->paramHandles[id].paramId == pq->paramId) {
+		int mapLen = module->getMapLen();
+		for (int id = 0; id < mapLen; id++) {
+			if (module->slots[id].paramHandle.moduleId == pq->module->id && module->slots[id].paramHandle.paramId == pq->paramId) {
 				std::string oscelotId = contextLabel != "" ? "on \"" + contextLabel + "\"" : "";
 				std::list<Widget*> w;
 				w.push_back(construct<MapMenuItem>(&MenuItem::text, string::f("Re-map %s", oscelotId.c_str()), &MapMenuItem::module, module, &MapMenuItem::pq, pq,
@@ -1379,6 +2118,78 @@ struct OscelotWidget : ThemedModuleWidget<OscelotModule>, ParamWidgetContextExte
 			}
 		};  // struct ContextMenuItem
 
+		struct DestinationsMenuItem : MenuItem {
+			OscelotModule* module;
+
+			DestinationsMenuItem() { rightText = RIGHT_ARROW; }
+
+			struct DestinationField : ui::TextField {
+				OscelotModule* module;
+				void onSelectKey(const event::SelectKey& e) override {
+					if (e.action == GLFW_PRESS && e.key == GLFW_KEY_ENTER) {
+						size_t separator = text.rfind(':');
+						if (separator != std::string::npos) {
+							try {
+								module->addDestination(text.substr(0, separator), std::stoi(text.substr(separator + 1)));
+							} catch (const std::exception& ex) {
+								WARN("Invalid OSC feedback destination: %s", text.c_str());
+							}
+						}
+
+						ui::MenuOverlay* overlay = getAncestorOfType<ui::MenuOverlay>();
+						overlay->requestDelete();
+						e.consume(this);
+					}
+
+					if (!e.getTarget()) {
+						ui::TextField::onSelectKey(e);
+					}
+				}
+			};
+
+			Menu* createChildMenu() override {
+				Menu* menu = new Menu;
+				std::vector<OscDestination> destinations = module->oscSender.getDestinations();
+
+				for (size_t i = 0; i < destinations.size(); i++) {
+					OscDestination destination = destinations[i];
+					std::string text = destination.getName();
+					if (destination.primary) text += " (panel)";
+					if (destination.autoRegistered) text += " (auto)";
+					if (destination.hasSubscriptions()) text += string::f(" (%i slots)", destination.getSubscribedCount(module->mappingTables.get()->capacity));
+					std::string counters = string::f("%u pkts, %.1f kB", destination.packetsSent, destination.bytesSent / 1024.0);
+					if (destination.packetsCoalesced > 0) counters += string::f(", %u coalesced", destination.packetsCoalesced);
+					if (destination.packetsEchoSuppressed > 0) counters += string::f(", %u echo", destination.packetsEchoSuppressed);
+					menu->addChild(createSubmenuItem(text, counters, [=](Menu* menu) {
+						menu->addChild(createCheckMenuItem("Enabled", "", [=]() { return module->oscSender.isDestinationEnabled(i); }, [=]() { module->oscSender.setDestinationEnabled(i, !module->oscSender.isDestinationEnabled(i)); }));
+						if (!destination.primary) {
+							menu->addChild(createMenuItem("Remove", "", [=]() { module->oscSender.removeDestination(i); }));
+						}
+					}));
+				}
+				if (destinations.size() > 0) {
+					menu->addChild(createMenuItem("Reset counters", "", [=]() { module->oscSender.resetDestinationCounters(); }));
+					menu->addChild(new MenuSeparator);
+				}
+
+				menu->addChild(createMenuLabel("Add destination (host:port)"));
+				DestinationField* destinationField = new DestinationField;
+				destinationField->placeholder = "192.168.0.10:8880";
+				destinationField->box.size.x = 160;
+				destinationField->module = module;
+				menu->addChild(destinationField);
+				return menu;
+			}
+		};  // struct DestinationsMenuItem
+
+		struct StatsMenuLabel : MenuLabel {
+			std::function<std::string()> getText;
+			void step() override {
+				text = getText();
+				MenuLabel::step();
+			}
+		};
+
 		menu->addChild(createSubmenuItem("User interface", "", [=](Menu* menu) {
 			menu->addChild(construct<ContextMenuItem>(&MenuItem::text, "Set Context Label", &ContextMenuItem::module, module));
 			menu->addChild(createBoolPtrMenuItem("Text scrolling", "",  &module->textScrolling));
@@ -1410,6 +2221,100 @@ struct OscelotWidget : ThemedModuleWidget<OscelotModule>, ParamWidgetContextExte
 			menu->addChild(createBoolPtrMenuItem("Send Full feedback", "", &module->alwaysSendFullFeedback ));
 		}));
 
+		menu->addChild(createSubmenuItem("Echo suppression", "", [=](Menu* menu) {
+			menu->addChild(createCheckMenuItem("Off", "", [=]() { return module->echoMode == ECHOMODE_OFF; }, [=]() { module->setEchoSuppression(ECHOMODE_OFF, module->echoHoldTime, module->echoMatchPort); }));
+			menu->addChild(createCheckMenuItem("Suppress feedback to sender", "", [=]() { return module->echoMode == ECHOMODE_SUPPRESS; }, [=]() { module->setEchoSuppression(ECHOMODE_SUPPRESS, module->echoHoldTime, module->echoMatchPort); }));
+			menu->addChild(createCheckMenuItem("Delay feedback to sender", "", [=]() { return module->echoMode == ECHOMODE_DELAY; }, [=]() { module->setEchoSuppression(ECHOMODE_DELAY, module->echoHoldTime, module->echoMatchPort); }));
+			menu->addChild(new MenuSeparator);
+			menu->addChild(createSubmenuItem("Hold time", string::f("%i ms", module->echoHoldTime), [=](Menu* menu) {
+				for (int holdTime : {50, 100, 250, 500, 1000}) {
+					menu->addChild(createCheckMenuItem(string::f("%i ms", holdTime), "", [=]() { return module->echoHoldTime == holdTime; }, [=]() { module->setEchoSuppression(module->echoMode, holdTime, module->echoMatchPort); }));
+				}
+			}));
+			menu->addChild(createCheckMenuItem("Match sender by address and port", "", [=]() { return module->echoMatchPort; }, [=]() { module->setEchoSuppression(module->echoMode, module->echoHoldTime, !module->echoMatchPort); }));
+		}));
+
+		menu->addChild(createSubmenuItem("Feedback rate limit", "", [=](Menu* menu) {
+			menu->addChild(createMenuLabel("Packets per destination"));
+			for (int packetRate : {0, 200, 100, 50, 25}) {
+				std::string text = packetRate == 0 ? "Unlimited" : string::f("%i / s", packetRate);
+				menu->addChild(createCheckMenuItem(text, "", [=]() { return module->feedbackPacketRate == packetRate; }, [=]() { module->setFeedbackRateLimit(packetRate, module->feedbackByteRate); }));
+			}
+			menu->addChild(new MenuSeparator);
+			menu->addChild(createMenuLabel("Bytes per destination"));
+			for (int byteRate : {0, 262144, 65536, 16384}) {
+				std::string text = byteRate == 0 ? "Unlimited" : string::f("%i kB / s", byteRate / 1024);
+				menu->addChild(createCheckMenuItem(text, "", [=]() { return module->feedbackByteRate == byteRate; }, [=]() { module->setFeedbackRateLimit(module->feedbackPacketRate, byteRate); }));
+			}
+		}));
+
+		menu->addChild(construct<DestinationsMenuItem>(&MenuItem::text, "Feedback destinations", &DestinationsMenuItem::module, module));
+		menu->addChild(createSubmenuItem("Auto-register clients", "", [=](Menu* menu) {
+			menu->addChild(createCheckMenuItem("Enabled", "", [=]() { return module->oscAutoClients; }, [=]() { module->setAutoClients(!module->oscAutoClients); }));
+			menu->addChild(new MenuSeparator);
+			menu->addChild(createMenuLabel("Reply port"));
+			menu->addChild(createCheckMenuItem("Source port of client", "", [=]() { return module->autoClientReplyPort == AUTOCLIENT_REPLYPORT_SOURCE; }, [=]() { module->autoClientReplyPort = AUTOCLIENT_REPLYPORT_SOURCE; }));
+			menu->addChild(createCheckMenuItem("Send port of panel", "", [=]() { return module->autoClientReplyPort == AUTOCLIENT_REPLYPORT_TX; }, [=]() { module->autoClientReplyPort = AUTOCLIENT_REPLYPORT_TX; }));
+			menu->addChild(createSubmenuItem("Idle timeout", string::f("%is", module->autoClientTimeout), [=](Menu* menu) {
+				for (int timeout : {10, 30, 60, 300}) {
+					menu->addChild(createCheckMenuItem(string::f("%is", timeout), "", [=]() { return module->autoClientTimeout == timeout; }, [=]() { module->autoClientTimeout = timeout; }));
+				}
+			}));
+			menu->addChild(createMenuItem("Forget clients now", "", [=]() { module->oscSender.removeAutoRegisteredClients(); }));
+		}));
+
+		menu->addChild(createSubmenuItem("Statistics", "", [=](Menu* menu) {
+			OscStats* stats = &module->stats;
+			std::vector<std::function<std::string()>> lines = {
+				[=]() { return string::f("Received: %llu packets, %.1f kB", (unsigned long long)stats->packetsIn, stats->bytesIn / 1024.0); },
+				[=]() { return string::f("Messages: %llu, queue high-water %u", (unsigned long long)stats->messagesIn, (unsigned)stats->queueHighWater); },
+				[=]() { return string::f("Parse errors: %llu, invalid messages: %llu", (unsigned long long)stats->parseErrors, (unsigned long long)stats->invalidMessages); },
+				[=]() { return string::f("Unknown addresses: %llu", (unsigned long long)stats->unknownAddresses); },
+				[=]() { return string::f("Sent: %llu packets, %.1f kB", (unsigned long long)stats->packetsOut, stats->bytesOut / 1024.0); },
+				[=]() { return string::f("Feedback: %.0f packets/s", (float)stats->feedbackRate); },
+				[=]() { return string::f("Tick: %.1f us, avg %.1f us, max %.1f us", (float)stats->tickTime, (float)stats->tickTimeAvg, (float)stats->tickTimeMax); },
+				[=]() { return string::f("Latency: p50 %.0f us, p99 %.0f us, max %.0f us", stats->latency.getPercentile(0.5f) / 1000.f, stats->latency.getPercentile(0.99f) / 1000.f, stats->latency.max / 1000.f); },
+			};
+			for (auto getText : lines) {
+				StatsMenuLabel* label = new StatsMenuLabel;
+				label->getText = getText;
+				label->text = getText();
+				menu->addChild(label);
+			}
+			menu->addChild(new MenuSeparator);
+			menu->addChild(createMenuItem("Reset", "", [=]() { module->resetStats(); }));
+#ifdef OSCELOT_TRACE
+			menu->addChild(createMenuItem("Save trace...", "", [=]() {
+				std::string path = selectFile(OSDIALOG_SAVE, "Chrome trace", "json");
+				if (!path.empty()) TraceBuffer::writeChromeTrace(path);
+			}));
+#endif
+		}));
+
+		menu->addChild(createSubmenuItem("Record and replay", "", [=](Menu* menu) {
+			OscReceiver* receiver = &module->oscReceiver;
+			if (receiver->recorder.isRecording()) {
+				menu->addChild(createMenuItem("Stop recording", string::f("%llu packets", (unsigned long long)receiver->recorder.getPacketCount()), [=]() { receiver->recorder.stop(); }));
+			} else {
+				menu->addChild(createMenuItem("Start recording...", "", [=]() {
+					std::string path = selectFile(OSDIALOG_SAVE, "OSC recording", "osclog");
+					if (!path.empty()) receiver->recorder.start(path);
+				}));
+			}
+			if (receiver->isReplaying()) {
+				menu->addChild(createMenuItem("Stop replay", string::f("%llu packets", (unsigned long long)receiver->getReplayedPacketCount()), [=]() { receiver->stopReplay(); }));
+			} else {
+				menu->addChild(createMenuItem("Replay at original timing...", "", [=]() {
+					std::string path = selectFile(OSDIALOG_OPEN, "OSC recording", "osclog");
+					if (!path.empty()) receiver->startReplay(path, true);
+				}));
+				menu->addChild(createMenuItem("Replay at maximum speed...", "", [=]() {
+					std::string path = selectFile(OSDIALOG_OPEN, "OSC recording", "osclog");
+					if (!path.empty()) receiver->startReplay(path, false);
+				}));
+			}
+		}));
+
 		menu->addChild(new MenuSeparator());
 		menu->addChild(createSubmenuItem("Map module", "", [=](Menu* menu) {
 			menu->addChild(createMenuItem("Clear first", RACK_MOD_CTRL_NAME "+" RACK_MOD_SHIFT_NAME "+D", [=]() { enableLearn(LEARN_MODE::BIND_CLEAR); }));
@@ -1420,6 +2325,18 @@ struct OscelotWidget : ThemedModuleWidget<OscelotModule>, ParamWidgetContextExte
 		appendContextMenuMem(menu);
 	}
 
+	std::string selectFile(osdialog_file_action action, std::string description, std::string extension) {
+		osdialog_filters* filters = osdialog_filters_parse(string::f("%s (.%s):%s", description.c_str(), extension.c_str(), extension.c_str()).c_str());
+		std::string filename = "oscelot." + extension;
+		char* pathC = osdialog_file(action, asset::user("").c_str(), action == OSDIALOG_SAVE ? filename.c_str() : NULL, filters);
+		osdialog_filters_free(filters);
+		if (!pathC) return "";
+		std::string path = pathC;
+		std::free(pathC);
+		if (action == OSDIALOG_SAVE && !string::endsWith(path, "." + extension)) path += "." + extension;
+		return path;
+	}
+
 	void appendContextMenuMem(Menu* menu) {
 		OscelotModule* module = dynamic_cast<OscelotModule*>(this->module);
 		assert(module);
@@ -1439,9 +2356,9 @@ struct OscelotWidget : ThemedModuleWidget<OscelotModule>, ParamWidgetContextExte
 		menu->addChild(createSubmenuItem("Store mapping", "", [=](Menu* menu) {
 			std::map<std::string, std::string> modulesToSave;
 
-			for (size_t i = 0; i < MAX_PARAMS; i++) {
-				if (module->paramHandles[i].moduleId < 0) continue;
-				Module* m = module->paramHandles[i].module;
+			for (int i = 0; i < module->getMapLen(); i++) {
+				if (module->slots[i].paramHandle.moduleId < 0) continue;
+				Module* m = module->slots[i].paramHandle.module;
 				if (!m) continue;
 
 				auto saveKey = string::f("%s %s", m->model->plugin->slug.c_str(), m->model->slug.c_str());
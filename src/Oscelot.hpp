@@ -4,12 +4,19 @@
 #include "osc/OscReceiver.hpp"
 #include "components/LedTextField.hpp"
 #include "components/MeowMory.hpp"
+#include "components/BankStager.hpp"
+#include "components/MappingTable.hpp"
+#include "components/ModuleOrder.hpp"
+#include "components/SlotStorage.hpp"
 #include "osc/OscController.hpp"
 
 namespace TheModularMind {
 namespace Oscelot {
 
-static const int MAX_PARAMS = 320;
+/** Mapping slots are added in blocks of this size whenever all of them are in use */
+static const int SLOT_BLOCK_SIZE = 32;
+/** Slots passed along the expander chain, later slots have no expander outputs */
+static const int MAX_EXPANDER_SLOTS = 320;
 static const std::string RXPORT_DEFAULT = "8881";
 static const std::string TXPORT_DEFAULT = "8880";
 
@@ -0,0 +1,254 @@
+#include <mutex>
+#include "OscelotCvExpander.hpp"
+#include "components/LedTextField.hpp"
+
+namespace TheModularMind {
+namespace Oscelot {
+
+/**
+ * Send expander on the left of OSC'elot: its CV inputs are sampled at the send rate and every
+ * channel which moved further than the threshold is sent by OSC'elot, all in one bundle.
+ */
+struct OscelotCvExpander : Module {
+	static const int NUM_CV_INPUTS = CvMessage::NUM_INPUTS;
+
+	enum ParamIds { NUM_PARAMS };
+	enum InputIds { ENUMS(CV_INPUT, NUM_CV_INPUTS), NUM_INPUTS };
+	enum OutputIds { NUM_OUTPUTS };
+	enum LightIds { ENUMS(SEND_LIGHT, NUM_CV_INPUTS), NUM_LIGHTS };
+
+	int panelTheme = rand() % 3;
+	/** Highest rate in Hz at which a channel is sent */
+	int rate;
+	/** Smallest change of a voltage which is sent */
+	float threshold;
+
+	dsp::ClockDivider sendDivider;
+	int channels[NUM_CV_INPUTS];
+	/** Voltages last sent, 16 channels of an input in 4 SIMD vectors */
+	simd::float_4 sent[NUM_CV_INPUTS][4];
+	CvMessages cvMessages;
+
+	/** Set by the UI under addressMutex, copied into the messages by the engine thread */
+	std::string address;
+	std::mutex addressMutex;
+	std::atomic<uint32_t> addressVersion{0};
+	uint32_t copiedAddressVersion;
+	char addressCopy[CvMessage::ADDRESS_LENGTH];
+
+	OscelotCvExpander() {
+		config(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS);
+		for (int i = 0; i < NUM_CV_INPUTS; i++) configInput(CV_INPUT + i, string::f("CV %d", i + 1));
+		onReset();
+	}
+
+	void onReset() override {
+		rate = 50;
+		threshold = 0.01f;
+		setAddress("/oscelot/cv");
+		resetChannels();
+		cvMessages.attach(rightExpander);
+	}
+
+	void resetChannels() {
+		for (int i = 0; i < NUM_CV_INPUTS; i++) {
+			channels[i] = 0;
+			for (int c = 0; c < 4; c++) sent[i][c] = INFINITY;
+		}
+		copiedAddressVersion = addressVersion - 1;
+		addressCopy[0] = '\0';
+	}
+
+	void setAddress(const std::string& text) {
+		std::lock_guard<std::mutex> lock(addressMutex);
+		address = text;
+		// No trailing slash, the channels are appended as /<input>/<channel>
+		while (address.size() > 1 && address.back() == '/') address.pop_back();
+		if (address.empty() || address[0] != '/') address = "/" + address;
+		addressVersion++;
+	}
+
+	std::string getAddress() {
+		std::lock_guard<std::mutex> lock(addressMutex);
+		return address;
+	}
+
+	void process(const ProcessArgs& args) override {
+		if (!rightExpander.module || rightExpander.module->model != modelOSCelot) return;
+		sendDivider.setDivision(std::max(1, int(args.sampleRate / rate)));
+		if (!sendDivider.process()) return;
+
+		CvMessage* message = CvMessages::getNext(rightExpander);
+		bool changed = false;
+		if (copiedAddressVersion != addressVersion) {
+			std::unique_lock<std::mutex> lock(addressMutex, std::try_to_lock);
+			if (lock.owns_lock()) {
+				std::strncpy(addressCopy, address.c_str(), CvMessage::ADDRESS_LENGTH - 1);
+				addressCopy[CvMessage::ADDRESS_LENGTH - 1] = '\0';
+				copiedAddressVersion = addressVersion;
+				// Everything is sent again to the new address
+				for (int i = 0; i < NUM_CV_INPUTS; i++) {
+					for (int c = 0; c < 4; c++) sent[i][c] = INFINITY;
+				}
+			} else if (addressCopy[0] == '\0') {
+				// Nothing to send before the first address has been copied
+				return;
+			}
+		}
+
+		float lightTime = sendDivider.getDivision() * args.sampleTime;
+		for (int i = 0; i < NUM_CV_INPUTS; i++) {
+			int numChannels = inputs[CV_INPUT + i].getChannels();
+			if (numChannels != channels[i]) {
+				// Channels which were added are sent right away
+				for (int c = 0; c < 4; c++) sent[i][c] = simd::ifelse(simd::float_4(4 * c) + simd::float_4(0.f, 1.f, 2.f, 3.f) >= float(channels[i]), INFINITY, sent[i][c]);
+				channels[i] = numChannels;
+				changed = true;
+			}
+
+			int changedMask = 0;
+			for (int c = 0; 4 * c < numChannels; c++) {
+				simd::float_4 voltage = inputs[CV_INPUT + i].getVoltageSimd<simd::float_4>(4 * c);
+				simd::float_4 moved = simd::fabs(voltage - sent[i][c]) > threshold;
+				sent[i][c] = simd::ifelse(moved, voltage, sent[i][c]);
+				changedMask |= simd::movemask(moved) << (4 * c);
+			}
+			changedMask &= (1 << numChannels) - 1;
+			message->changed[i] = changedMask;
+			message->channels[i] = numChannels;
+			for (int c = 0; c < 4; c++) sent[i][c].store(message->values[i] + 4 * c);
+			changed |= changedMask != 0;
+			lights[SEND_LIGHT + i].setBrightnessSmooth(changedMask ? 1.f : 0.f, lightTime);
+		}
+		if (!changed) return;
+
+		std::memcpy(message->address, addressCopy, sizeof(addressCopy));
+		message->version = CvMessages::getSent(rightExpander)->version + 1;
+		rightExpander.requestMessageFlip();
+	}
+
+	json_t* dataToJson() override {
+		json_t* rootJ = json_object();
+		json_object_set_new(rootJ, "panelTheme", json_integer(panelTheme));
+		json_object_set_new(rootJ, "rate", json_integer(rate));
+		json_object_set_new(rootJ, "threshold", json_real(threshold));
+		json_object_set_new(rootJ, "address", json_string(getAddress().c_str()));
+		return rootJ;
+	}
+
+	void dataFromJson(json_t* rootJ) override {
+		panelTheme = json_integer_value(json_object_get(rootJ, "panelTheme"));
+		json_t* rateJ = json_object_get(rootJ, "rate");
+		if (rateJ) rate = clamp((int)json_integer_value(rateJ), 1, 1000);
+		json_t* thresholdJ = json_object_get(rootJ, "threshold");
+		if (thresholdJ) threshold = json_real_value(thresholdJ);
+		json_t* addressJ = json_object_get(rootJ, "address");
+		if (addressJ) setAddress(json_string_value(addressJ));
+	}
+};
+
+/** Addresses of the inputs */
+struct OscCvLabelWidget : widget::OpaqueWidget {
+	OscelotCvExpander* module;
+	OscelotTextLabel* labelWidgets[OscelotCvExpander::NUM_CV_INPUTS];
+	uint32_t addressVersion = 0;
+
+	void step() override {
+		if (!module || module->addressVersion == addressVersion) return;
+		addressVersion = module->addressVersion;
+		std::string address = module->getAddress();
+		for (int i = 0; i < OscelotCvExpander::NUM_CV_INPUTS; i++) labelWidgets[i]->text = string::f("%s/%d", address.c_str(), i + 1);
+	}
+
+	void setLabels() {
+		clearChildren();
+
+		Vec lblPos = box.pos;
+		OscelotTextLabel* l = createWidget<OscelotTextLabel>(lblPos);
+		l->box.size = mm2px(Vec(25.4, 1));
+		l->text = "CV > OSC";
+		addChild(l);
+		lblPos = lblPos.plus(Vec(0.0f, 16.0f));
+
+		for (int i = 0; i < OscelotCvExpander::NUM_CV_INPUTS; i++) {
+			lblPos = lblPos.plus(Vec(0.0f, 36.0f));
+			OscelotTextLabel* l = createWidget<OscelotTextLabel>(lblPos);
+			l->box.size = mm2px(Vec(25.4, 1));
+			addChild(l);
+			labelWidgets[i] = l;
+		}
+	}
+};
+
+struct OscelotCvExpanderWidget : ThemedModuleWidget<OscelotCvExpander> {
+	OscelotCvExpanderWidget(OscelotCvExpander* module) : ThemedModuleWidget<OscelotCvExpander>(module, "OscelotExpander", "Oscelot.md#cv-expander") {
+		setModule(module);
+
+		addChild(createWidget<PawScrew>(Vec(2 * RACK_GRID_WIDTH, 0)));
+		addChild(createWidget<PawScrew>(Vec(box.size.x - 3 * RACK_GRID_WIDTH, RACK_GRID_HEIGHT - RACK_GRID_WIDTH)));
+
+		OscCvLabelWidget* oscLabelWidget = createWidget<OscCvLabelWidget>(mm2px(Vec(0, 7)));
+		oscLabelWidget->module = module;
+		if (module) {
+			oscLabelWidget->setLabels();
+		}
+		addChild(oscLabelWidget);
+
+		// Same rows as the outputs of the expander
+		Vec inputPos = mm2px(Vec(7, 14)).plus(Vec(0.0f, 16.0f));
+		Vec lightPos = mm2px(Vec(18.4, 14)).plus(Vec(0.0f, 16.0f));
+		for (int i = 0; i < OscelotCvExpander::NUM_CV_INPUTS; i++) {
+			inputPos = inputPos.plus(Vec(0.0f, 36.0f));
+			lightPos = lightPos.plus(Vec(0.0f, 36.0f));
+			addInput(createInputCentered<PawPort>(inputPos, module, OscelotCvExpander::CV_INPUT + i));
+			addChild(createLightCentered<SmallLight<GreenLight>>(lightPos, module, OscelotCvExpander::SEND_LIGHT + i));
+		}
+	}
+
+	void appendContextMenu(Menu* menu) override {
+		ThemedModuleWidget<OscelotCvExpander>::appendContextMenu(menu);
+		assert(module);
+
+		struct AddressField : ui::TextField {
+			OscelotCvExpander* module;
+			void onSelectKey(const event::SelectKey& e) override {
+				if (e.action == GLFW_PRESS && e.key == GLFW_KEY_ENTER) {
+					module->setAddress(text);
+
+					ui::MenuOverlay* overlay = getAncestorOfType<ui::MenuOverlay>();
+					overlay->requestDelete();
+					e.consume(this);
+				}
+
+				if (!e.getTarget()) {
+					ui::TextField::onSelectKey(e);
+				}
+			}
+		};
+
+		menu->addChild(new MenuSeparator());
+		menu->addChild(createMenuLabel("Address"));
+		AddressField* addressField = new AddressField;
+		addressField->placeholder = "/oscelot/cv";
+		addressField->box.size.x = 160;
+		addressField->module = module;
+		addressField->text = module->getAddress();
+		menu->addChild(addressField);
+
+		menu->addChild(createSubmenuItem(string::f("Send rate (%d Hz)", module->rate), "", [=](Menu* menu) {
+			for (int rate : {10, 25, 50, 100, 200, 500}) {
+				menu->addChild(createCheckMenuItem(string::f("%d Hz", rate), "", [=]() { return module->rate == rate; }, [=]() { module->rate = rate; }));
+			}
+		}));
+		menu->addChild(createSubmenuItem(string::f("Threshold (%g mV)", module->threshold * 1000.f), "", [=](Menu* menu) {
+			menu->addChild(createCheckMenuItem("Any change", "", [=]() { return module->threshold == 0.f; }, [=]() { module->threshold = 0.f; }));
+			for (float threshold : {0.001f, 0.005f, 0.01f, 0.05f, 0.1f}) {
+				menu->addChild(createCheckMenuItem(string::f("%g mV", threshold * 1000.f), "", [=]() { return module->threshold == threshold; }, [=]() { module->threshold = threshold; }));
+			}
+		}));
+	}
+};
+}  // namespace Oscelot
+}  // namespace TheModularMind
+
+Model* modelOscelotCvExpander = createModel<TheModularMind::Oscelot::OscelotCvExpander, TheModularMind::Oscelot::OscelotCvExpanderWidget>("OSCelotCVExpander");
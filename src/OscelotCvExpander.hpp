@@ -0,0 +1,46 @@
+#pragma once
+#include <cstring>
+#include "plugin.hpp"
+
+namespace TheModularMind {
+namespace Oscelot {
+
+/**
+ * CV voltages of the send expander on the left of OSC'elot, published at most at the send rate
+ * and only when a voltage moved further than the threshold since it was last sent.
+ */
+struct CvMessage {
+	static const int NUM_INPUTS = 8;
+	static const int ADDRESS_LENGTH = 48;
+
+	/** Incremented on every publish, a gap means changes were missed */
+	uint32_t version = 0;
+	/** Address prefix, the channels are sent to <address>/<input>/<channel> */
+	char address[ADDRESS_LENGTH] = {};
+	/** Channels of the inputs, 0 if disconnected */
+	int channels[NUM_INPUTS] = {};
+	/** Channels changed since the previous version, one bit per channel */
+	uint16_t changed[NUM_INPUTS] = {};
+	/** Last sent voltages */
+	float values[NUM_INPUTS][16] = {};
+};
+
+/** The pair of messages of the send expander for OSC'elot on its right */
+struct CvMessages {
+	CvMessage messages[2];
+
+	void attach(Module::Expander& expander) {
+		expander.producerMessage = &messages[0];
+		expander.consumerMessage = &messages[1];
+		expander.messageFlipRequested = false;
+	}
+
+	/** Message OSC'elot currently reads */
+	static CvMessage* getSent(Module::Expander& expander) { return reinterpret_cast<CvMessage*>(expander.consumerMessage); }
+
+	/** Message to write, OSC'elot reads it after requestMessageFlip() */
+	static CvMessage* getNext(Module::Expander& expander) { return reinterpret_cast<CvMessage*>(expander.producerMessage); }
+};
+
+} // namespace Oscelot
+} // namespace TheModularMind
@@ -3,21 +3,14 @@
 namespace TheModularMind {
 namespace Oscelot {
 
-struct OscelotExpander : Module {
+struct OscelotExpander : ExpanderModule {
 	enum ParamIds { NUM_PARAMS };
 	enum InputIds { NUM_INPUTS };
 	enum OutputIds { ENUMS(TRIG_OUTPUT, 8), ENUMS(CV_OUTPUT, 8), ENUMS(POLY_OUTPUT, 2), NUM_OUTPUTS };
 	enum LightIds { NUM_LIGHTS };
 
-	int panelTheme = rand() % 3;
-	int expanderId;
-	int startVoltageIndex = 1;
-	int endVoltageIndex = 7;
-	float controlVoltages[9] = { -10.0f, -5.0f, -3.0f, -1.0f , 0.0f, 1.0f, 3.0f, 5.0f, 10.0f };
-	dsp::ClockDivider processDivider;
-	dsp::PulseGenerator pulseGenerator[8];
-	simd::float_4 last[2];
-	std::string labels[8];
+	ExpanderChannels<2> channels;
+	char labels[8][ExpanderMessage::LABEL_LENGTH];
 
 	OscelotExpander() {
 		config(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS);
@@ -25,80 +18,62 @@ struct OscelotExpander : Module {
 	}
 
 	void onReset() override {
-		processDivider.setDivision(64);
-		processDivider.reset();
-
+		channels.reset();
 		for (int i = 0; i < 8; i++) {
-			labels[i] = "";
-			last[i / 4][i % 4] = 0.0f;
-			pulseGenerator[i].reset();
+			labels[i][0] = '\0';
+			outputs[TRIG_OUTPUT + i].clearVoltages();
 			outputs[CV_OUTPUT + i].clearVoltages();
-			outputs[POLY_OUTPUT_LAST].clearVoltages();
 		}
+		outputs[POLY_OUTPUT].clearVoltages();
+		outputs[POLY_OUTPUT_LAST].clearVoltages();
 		expanderId = 0;
-		rightExpander.producerMessage = NULL;
-		rightExpander.messageFlipRequested = false;
+		valuesVersion = 0;
+		labelsVersion = 0;
+		connected = false;
+		connectedOutputs = 0;
+		expanderMessages.attach(rightExpander);
 	}
 
+	/** Runs every sample so triggers and steps of the CV are sample accurate */
 	void process(const ProcessArgs& args) override {
-		if (processDivider.process()) {
-			Module* expanderMother = leftExpander.module;
-			OscelotExpanderBase* module;
-
-			if (!expanderMother || (expanderMother->model != modelOSCelot && expanderMother->model != modelOscelotExpander) || !expanderMother->rightExpander.consumerMessage) {
-				onReset();
-				return;
-			}
+		ExpanderMessage* message = getMessage();
+		if (!message) {
+			if (connected) onReset();
+			return;
+		}
+		connected = true;
 
-			ExpanderPayload* expPayload = reinterpret_cast<ExpanderPayload*>(expanderMother->rightExpander.consumerMessage);
-			module = reinterpret_cast<OscelotExpanderBase*>(expPayload->base);
-			expanderId = expPayload->expanderId;
+		bool moved = message->expanderId != expanderId;
+		if (moved) {
+			expanderId = message->expanderId;
+			channels.reset();
+		}
+		if (expanderId + 8 > MAX_EXPANDER_SLOTS) return;
 
-			if (expanderId + 8 > MAX_PARAMS) return;
+		if (moved || message->labelsVersion != labelsVersion) {
+			std::memcpy(labels, message->labels[expanderId], sizeof(labels));
+			labelsVersion = message->labelsVersion;
+		}
+		if (moved || message->valuesVersion != valuesVersion) {
+			channels.receive(message->values + expanderId, 2, args.sampleRate, smoothing);
+			valuesVersion = message->valuesVersion;
+		}
 
-			float* values = module->expGetValues();
-			std::string* controllerLabels = module->expGetLabels();
+		if (outputsPlugged()) channels.refresh();
+		if (channels.process(2, args.sampleTime, getLowVoltage(), getVoltageRange())) {
 			outputs[POLY_OUTPUT].setChannels(8);
 			outputs[POLY_OUTPUT_LAST].setChannels(8);
-
-			for (int i = 0; i < 8; i++) {
-				float v = values[i + expanderId];
-				if (v < 0.0f) return;
-				labels[i] = controllerLabels[i + expanderId];
-
-				bool trig = simd::ifelse(last[i / 4][i % 4] != v, 1, 0);
-
-				if (trig) {
-					pulseGenerator[i].trigger(1e-3);
-					last[i / 4][i % 4] = v;
+			for (int c = 0; c < 2; c++) {
+				outputs[POLY_OUTPUT].setVoltageSimd(channels.trig[c], 4 * c);
+				outputs[POLY_OUTPUT_LAST].setVoltageSimd(channels.cv[c], 4 * c);
+				for (int i = 0; i < 4; i++) {
+					outputs[TRIG_OUTPUT + 4 * c + i].setVoltage(channels.trig[c][i]);
+					outputs[CV_OUTPUT + 4 * c + i].setVoltage(channels.cv[c][i]);
 				}
-
-				simd::float_4 trigVoltage = pulseGenerator[i].process(args.sampleTime) ? 10.f : 0.f;
-				simd::float_4 cvVoltage = simd::rescale(v, 0.0f, 1.0f, controlVoltages[startVoltageIndex], controlVoltages[endVoltageIndex]);
-
-				outputs[TRIG_OUTPUT + i].setVoltage(trigVoltage[0]);
-				outputs[POLY_OUTPUT].setVoltage(trigVoltage[0], i);
-				outputs[CV_OUTPUT + i].setVoltage(cvVoltage[0]);
-				outputs[POLY_OUTPUT_LAST].setVoltage(cvVoltage[0], i);
 			}
-
-			rightExpander.producerMessage = new ExpanderPayload(module, expanderId + 8);
-			rightExpander.messageFlipRequested = true;
 		}
-	}
-
-	json_t* dataToJson() override {
-		json_t* rootJ = json_object();
-		json_object_set_new(rootJ, "panelTheme", json_integer(panelTheme));
-		json_object_set_new(rootJ, "startVoltageIndex", json_real(startVoltageIndex));
-		json_object_set_new(rootJ, "endVoltageIndex", json_real(endVoltageIndex));
-		return rootJ;
-	}
 
-	void dataFromJson(json_t* rootJ) override {
-		panelTheme = json_integer_value(json_object_get(rootJ, "panelTheme"));
-		startVoltageIndex = json_real_value(json_object_get(rootJ, "startVoltageIndex"));
-		endVoltageIndex = json_real_value(json_object_get(rootJ, "endVoltageIndex"));
+		expSend(message, expanderId + 8);
 	}
 };
 
@@ -172,63 +147,7 @@ struct OscelotExpanderWidget : ThemedModuleWidget<OscelotExpander> {
 		ThemedModuleWidget<OscelotExpander>::appendContextMenu(menu);
 		assert(module);
 
-		menu->addChild(new MenuSeparator());
-		menu->addChild(createMenuLabel(string::f("CV Range: %.0fV to %.0fV", module->controlVoltages[ module->startVoltageIndex], module->controlVoltages[ module->endVoltageIndex])));
-		
-		menu->addChild(createSubmenuItem("Configure CV", "", [=](Menu* menu) {
-			menu->addChild(createSubmenuItem(string::f("Voltage Range (%.0fV)", abs(module->controlVoltages[module->startVoltageIndex] - module->controlVoltages[module->endVoltageIndex])), "", [=](Menu* menu) {
-					menu->addChild(createCheckMenuItem(
-						"-1V to 1V", "", [=]() { return module->startVoltageIndex == 3 && module->endVoltageIndex == 5; },
-						[=]() {
-							module->startVoltageIndex = 3;
-							module->endVoltageIndex = 5;
-						}));
-					menu->addChild(createCheckMenuItem(
-						"-3V to 3V", "", [=]() { return module->startVoltageIndex == 2 && module->endVoltageIndex == 6; },
-						[=]() {
-							module->startVoltageIndex = 2;
-							module->endVoltageIndex = 6;
-						}));
-					menu->addChild(createCheckMenuItem(
-						"-5V to 5V", "", [=]() { return module->startVoltageIndex == 1 && module->endVoltageIndex == 7; },
-						[=]() {
-							module->startVoltageIndex = 1;
-							module->endVoltageIndex = 7;
-						}));
-					menu->addChild(createCheckMenuItem(
-						"-10V to 10V", "", [=]() { return module->startVoltageIndex == 0 && module->endVoltageIndex == 8; },
-						[=]() {
-							module->startVoltageIndex = 0;
-							module->endVoltageIndex = 8;
-						}));
-					menu->addChild(createCheckMenuItem(
-						"0V to 1V", "", [=]() { return module->startVoltageIndex == 4 && module->endVoltageIndex == 5; },
-						[=]() {
-							module->startVoltageIndex = 4;
-							module->endVoltageIndex = 5;
-						}));
-					menu->addChild(createCheckMenuItem(
-						"0V to 3V", "", [=]() { return module->startVoltageIndex == 4 && module->endVoltageIndex == 6; },
-						[=]() {
-							module->startVoltageIndex = 4;
-							module->endVoltageIndex = 6;
-						}));
-					menu->addChild(createCheckMenuItem(
-						"0V to 5V", "", [=]() { return module->startVoltageIndex == 4 && module->endVoltageIndex == 7; },
-						[=]() {
-							module->startVoltageIndex = 4;
-							module->endVoltageIndex = 7;
-						}));
-					menu->addChild(createCheckMenuItem(
-						"0V to 10V", "", [=]() { return module->startVoltageIndex == 4 && module->endVoltageIndex == 8; },
-						[=]() {
-							module->startVoltageIndex = 4;
-							module->endVoltageIndex = 8;
-						}));
-			    }));
-			menu->addChild(createIndexPtrSubmenuItem("Start Voltage", { "-10 V", "-5 V", "-3 V", "-1 V" , "0 V", "1 V", "3 V", "5 V", "10 V" }, &module->startVoltageIndex));
-			menu->addChild(createIndexPtrSubmenuItem("End Voltage", { "-10 V", "-5 V", "-3 V", "-1 V" , "0 V", "1 V", "3 V", "5 V", "10 V" }, &module->endVoltageIndex));
-		}));
+		appendExpanderMenu(menu, module);
 	}
 };
 }  // namespace Oscelot
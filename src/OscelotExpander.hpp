@@ -1,4 +1,5 @@
 #pragma once
+#include <cstring>
 #include "plugin.hpp"
 #include "components/LedTextField.hpp"
 #include "Oscelot.hpp"
@@ -6,20 +7,291 @@
 namespace TheModularMind {
 namespace Oscelot {
 
-struct OscelotExpanderBase {
-	virtual float* expGetValues() { return NULL; }
-	virtual std::string* expGetLabels() { return NULL; }
+/**
+ * Snapshot of the mapping slots passed along the chain of expanders. Every module owns two
+ * preallocated messages for its right neighbour and only writes and flips them when a version
+ * changed, so the chain neither allocates nor copies anything while nothing changes.
+ */
+struct ExpanderMessage {
+	static const int LABEL_LENGTH = 16;
+
+	/** Changes whenever any of the values changed */
+	uint32_t valuesVersion = 0;
+	/** Changes whenever the mappings and with them the labels changed */
+	uint32_t labelsVersion = 0;
+	/** First slot of the receiving expander */
+	int expanderId = 0;
+	float values[MAX_EXPANDER_SLOTS] = {};
+	char labels[MAX_EXPANDER_SLOTS][LABEL_LENGTH] = {};
+
+	static void setLabel(char* label, const std::string& text) {
+		std::strncpy(label, text.c_str(), LABEL_LENGTH - 1);
+		label[LABEL_LENGTH - 1] = '\0';
+	}
 };
 
-struct ExpanderPayload {
-	OscelotExpanderBase* base;
-	int expanderId;
-	
-	ExpanderPayload(OscelotExpanderBase* base, int expanderId) {
-		this->base = base;
-		this->expanderId = expanderId;
+/** The pair of messages of a module for its right neighbour */
+struct ExpanderMessages {
+	ExpanderMessage messages[2];
+
+	void attach(Module::Expander& expander) {
+		expander.producerMessage = &messages[0];
+		expander.consumerMessage = &messages[1];
+		expander.messageFlipRequested = false;
+	}
+
+	/** Message the neighbour currently reads */
+	static ExpanderMessage* getSent(Module::Expander& expander) { return reinterpret_cast<ExpanderMessage*>(expander.consumerMessage); }
+
+	/** Message to write, the neighbour reads it after requestMessageFlip() */
+	static ExpanderMessage* getNext(Module::Expander& expander) { return reinterpret_cast<ExpanderMessage*>(expander.producerMessage); }
+
+	/** Passes a received message on to the neighbour when it has changed, the neighbour starts at the given slot */
+	static void forward(Module::Expander& expander, const ExpanderMessage* received, int expanderId) {
+		ExpanderMessage* sent = getSent(expander);
+		if (sent->valuesVersion == received->valuesVersion && sent->labelsVersion == received->labelsVersion && sent->expanderId == expanderId) return;
+
+		ExpanderMessage* message = getNext(expander);
+		if (message->labelsVersion != received->labelsVersion) {
+			std::memcpy(message->labels, received->labels, sizeof(message->labels));
+			message->labelsVersion = received->labelsVersion;
+		}
+		std::memcpy(message->values, received->values, sizeof(message->values));
+		message->valuesVersion = received->valuesVersion;
+		message->expanderId = expanderId;
+		expander.requestMessageFlip();
 	}
 };
 
+/** Modules which read the messages of their left neighbour and pass them on to the right */
+inline bool isExpander(Model* model) { return model == modelOscelotExpander || model == modelOscelotExpanderPoly; }
+
+/**
+ * Triggers and CVs of a range of slots, 4 channels per SIMD vector. Triggers fire on the sample a
+ * changed value is received, CVs either step or ramp linearly to it. Nothing is computed while no
+ * trigger or ramp is running, the outputs keep their voltages in the meantime.
+ */
+template <int NUM_VECTORS>
+struct ExpanderChannels {
+	static const int NUM_CHANNELS = 4 * NUM_VECTORS;
+	/** Upper limit of a ramp, the length of a ramp follows the interval of the received values */
+	static constexpr float MAX_RAMP_TIME = 0.05f;
+	static constexpr float PULSE_TIME = 1e-3f;
+
+	simd::float_4 trig[NUM_VECTORS];
+	simd::float_4 cv[NUM_VECTORS];
+
+	ExpanderChannels() { reset(); }
+
+	void reset() {
+		for (int c = 0; c < NUM_VECTORS; c++) {
+			target[c] = -1.f;
+			current[c] = 0.f;
+			delta[c] = 0.f;
+			rampRemaining[c] = 0.f;
+			sinceChange[c] = 0.f;
+			pulseRemaining[c] = 0.f;
+			trig[c] = 0.f;
+			cv[c] = 0.f;
+		}
+		busy = true;
+	}
+
+	/** Computes the outputs on the next call of process() even if nothing changed */
+	void refresh() { busy = true; }
+
+	/** Triggers the channels whose value changed and starts their ramps */
+	void receive(const float* values, int numVectors, float sampleRate, bool smoothing) {
+		// Counted here rather than on every sample, ramps never get longer than MAX_RAMP_TIME anyway
+		float elapsed = float(frame - receiveFrame);
+		receiveFrame = frame;
+		float maxRamp = sampleRate * MAX_RAMP_TIME;
+		for (int c = 0; c < numVectors; c++) {
+			simd::float_4 value = simd::float_4::load(values + 4 * c);
+			simd::float_4 mapped = value >= 0.f;
+			simd::float_4 changed = mapped & (value != target[c]);
+			sinceChange[c] = simd::fmin(sinceChange[c] + elapsed, maxRamp);
+			pulseRemaining[c] = simd::ifelse(changed, PULSE_TIME, pulseRemaining[c]);
+			if (smoothing) {
+				// Ramp over the interval since the previous value, a newly mapped channel jumps
+				simd::float_4 ramp = simd::fmax(sinceChange[c], 1.f);
+				simd::float_4 from = simd::ifelse(target[c] >= 0.f, current[c], value);
+				current[c] = simd::ifelse(changed, from, current[c]);
+				delta[c] = simd::ifelse(changed, (value - from) / ramp, delta[c]);
+				rampRemaining[c] = simd::ifelse(changed, ramp, rampRemaining[c]);
+			} else {
+				rampRemaining[c] = 0.f;
+			}
+			sinceChange[c] = simd::ifelse(changed, 0.f, sinceChange[c]);
+			target[c] = simd::ifelse(mapped, value, target[c]);
+		}
+		busy = true;
+	}
+
+	/** Called on every sample, false if trig and cv are unchanged since the last call */
+	bool process(int numVectors, float sampleTime, float low, float range) {
+		frame++;
+		if (!busy && low == lastLow && range == lastRange) return false;
+		lastLow = low;
+		lastRange = range;
+
+		int active = 0;
+		for (int c = 0; c < numVectors; c++) {
+			// A ramp ends exactly on the received value
+			simd::float_4 ramping = rampRemaining[c] > 0.f;
+			current[c] = simd::ifelse(ramping, current[c] + delta[c], target[c]);
+			rampRemaining[c] -= simd::ifelse(ramping, 1.f, 0.f);
+
+			simd::float_4 pulse = pulseRemaining[c] > 0.f;
+			pulseRemaining[c] -= simd::ifelse(pulse, sampleTime, 0.f);
+			trig[c] = simd::ifelse(pulse, 10.f, 0.f);
+			// Outputs of unmapped slots keep their last voltage
+			cv[c] = simd::ifelse(target[c] >= 0.f, low + current[c] * range, cv[c]);
+			// One more pass after the last trigger or ramp sample to settle the outputs
+			active |= simd::movemask(ramping | pulse);
+		}
+		busy = active != 0;
+		return true;
+	}
+
+   private:
+	simd::float_4 target[NUM_VECTORS];
+	simd::float_4 current[NUM_VECTORS];
+	simd::float_4 delta[NUM_VECTORS];
+	simd::float_4 rampRemaining[NUM_VECTORS];
+	/** Samples since the value of a channel last changed, up to the longest ramp */
+	simd::float_4 sinceChange[NUM_VECTORS];
+	simd::float_4 pulseRemaining[NUM_VECTORS];
+	uint32_t frame = 0;
+	uint32_t receiveFrame = 0;
+	bool busy = true;
+	float lastLow = 0.f;
+	float lastRange = 0.f;
+};
+
+/** Settings and the link to the chain shared by the expanders */
+struct ExpanderModule : Module {
+	int panelTheme = rand() % 3;
+	/** First slot of this expander, given by its position in the chain */
+	int expanderId = 0;
+	int startVoltageIndex = 1;
+	int endVoltageIndex = 7;
+	float controlVoltages[9] = { -10.0f, -5.0f, -3.0f, -1.0f , 0.0f, 1.0f, 3.0f, 5.0f, 10.0f };
+	/** Interpolates the CV outputs between received values instead of stepping */
+	bool smoothing = false;
+	/** Versions of the message last read from the left */
+	uint32_t valuesVersion = 0;
+	uint32_t labelsVersion = 0;
+	bool connected = false;
+	ExpanderMessages expanderMessages;
+	/** Bit mask of the outputs with cables */
+	uint64_t connectedOutputs = 0;
+
+	float getLowVoltage() { return controlVoltages[startVoltageIndex]; }
+	float getVoltageRange() { return controlVoltages[endVoltageIndex] - controlVoltages[startVoltageIndex]; }
+
+	/** Message sent by the module on the left, nullptr if it isn't OSC'elot or an expander */
+	ExpanderMessage* getMessage() {
+		Module* expanderMother = leftExpander.module;
+		if (!expanderMother || (expanderMother->model != modelOSCelot && !isExpander(expanderMother->model)) || !expanderMother->rightExpander.consumerMessage) return nullptr;
+		return ExpanderMessages::getSent(expanderMother->rightExpander);
+	}
+
+	/** True if cables were plugged in since the last call, the engine has cleared their voltages */
+	bool outputsPlugged() {
+		uint64_t mask = 0;
+		for (size_t i = 0; i < outputs.size(); i++) {
+			if (outputs[i].isConnected()) mask |= 1ULL << i;
+		}
+		bool plugged = (mask & ~connectedOutputs) != 0;
+		connectedOutputs = mask;
+		return plugged;
+	}
+
+	/** Passes the message on to the next expander, which starts at the given slot */
+	void expSend(const ExpanderMessage* received, int nextExpanderId) {
+		if (rightExpander.module && isExpander(rightExpander.module->model)) ExpanderMessages::forward(rightExpander, received, nextExpanderId);
+	}
+
+	json_t* dataToJson() override {
+		json_t* rootJ = json_object();
+		json_object_set_new(rootJ, "panelTheme", json_integer(panelTheme));
+		json_object_set_new(rootJ, "startVoltageIndex", json_real(startVoltageIndex));
+		json_object_set_new(rootJ, "endVoltageIndex", json_real(endVoltageIndex));
+		json_object_set_new(rootJ, "smoothing", json_boolean(smoothing));
+		return rootJ;
+	}
+
+	void dataFromJson(json_t* rootJ) override {
+		panelTheme = json_integer_value(json_object_get(rootJ, "panelTheme"));
+		startVoltageIndex = json_real_value(json_object_get(rootJ, "startVoltageIndex"));
+		endVoltageIndex = json_real_value(json_object_get(rootJ, "endVoltageIndex"));
+		smoothing = json_boolean_value(json_object_get(rootJ, "smoothing"));
+	}
+};
+
+
+/** CV settings in the context menu of the expanders */
+inline void appendExpanderMenu(Menu* menu, ExpanderModule* module) {
+	menu->addChild(new MenuSeparator());
+	menu->addChild(createMenuLabel(string::f("CV Range: %.0fV to %.0fV", module->controlVoltages[ module->startVoltageIndex], module->controlVoltages[ module->endVoltageIndex])));
+	
+	menu->addChild(createSubmenuItem("Configure CV", "", [=](Menu* menu) {
+		menu->addChild(createSubmenuItem(string::f("Voltage Range (%.0fV)", abs(module->controlVoltages[module->startVoltageIndex] - module->controlVoltages[module->endVoltageIndex])), "", [=](Menu* menu) {
+				menu->addChild(createCheckMenuItem(
+					"-1V to 1V", "", [=]() { return module->startVoltageIndex == 3 && module->endVoltageIndex == 5; },
+					[=]() {
+						module->startVoltageIndex = 3;
+						module->endVoltageIndex = 5;
+					}));
+				menu->addChild(createCheckMenuItem(
+					"-3V to 3V", "", [=]() { return module->startVoltageIndex == 2 && module->endVoltageIndex == 6; },
+					[=]() {
+						module->startVoltageIndex = 2;
+						module->endVoltageIndex = 6;
+					}));
+				menu->addChild(createCheckMenuItem(
+					"-5V to 5V", "", [=]() { return module->startVoltageIndex == 1 && module->endVoltageIndex == 7; },
+					[=]() {
+						module->startVoltageIndex = 1;
+						module->endVoltageIndex = 7;
+					}));
+				menu->addChild(createCheckMenuItem(
+					"-10V to 10V", "", [=]() { return module->startVoltageIndex == 0 && module->endVoltageIndex == 8; },
+					[=]() {
+						module->startVoltageIndex = 0;
+						module->endVoltageIndex = 8;
+					}));
+				menu->addChild(createCheckMenuItem(
+					"0V to 1V", "", [=]() { return module->startVoltageIndex == 4 && module->endVoltageIndex == 5; },
+					[=]() {
+						module->startVoltageIndex = 4;
+						module->endVoltageIndex = 5;
+					}));
+				menu->addChild(createCheckMenuItem(
+					"0V to 3V", "", [=]() { return module->startVoltageIndex == 4 && module->endVoltageIndex == 6; },
+					[=]() {
+						module->startVoltageIndex = 4;
+						module->endVoltageIndex = 6;
+					}));
+				menu->addChild(createCheckMenuItem(
+					"0V to 5V", "", [=]() { return module->startVoltageIndex == 4 && module->endVoltageIndex == 7; },
+					[=]() {
+						module->startVoltageIndex = 4;
+						module->endVoltageIndex = 7;
+					}));
+				menu->addChild(createCheckMenuItem(
+					"0V to 10V", "", [=]() { return module->startVoltageIndex == 4 && module->endVoltageIndex == 8; },
+					[=]() {
+						module->startVoltageIndex = 4;
+						module->endVoltageIndex = 8;
+					}));
+		    }));
+		menu->addChild(createIndexPtrSubmenuItem("Start Voltage", { "-10 V", "-5 V", "-3 V", "-1 V" , "0 V", "1 V", "3 V", "5 V", "10 V" }, &module->startVoltageIndex));
+		menu->addChild(createIndexPtrSubmenuItem("End Voltage", { "-10 V", "-5 V", "-3 V", "-1 V" , "0 V", "1 V", "3 V", "5 V", "10 V" }, &module->endVoltageIndex));
+	}));
+	menu->addChild(createBoolPtrMenuItem("Smooth CV", "", &module->smoothing));
+}
+
 } // namespace Oscelot
-} // namespace TheModularMind
\ No newline at end of file
+} // namespace TheModularMind
@@ -0,0 +1,181 @@
+#include "OscelotExpander.hpp"
+
+namespace TheModularMind {
+namespace Oscelot {
+
+/**
+ * Expander for large mapping sets: a window of up to 128 slots on 16-channel polyphonic trigger
+ * and CV outputs, so a single module covers as many slots as 16 of the 8-slot expanders.
+ */
+struct OscelotExpanderPoly : ExpanderModule {
+	static const int MAX_WIDTH = 128;
+	static const int NUM_CABLES = MAX_WIDTH / 16;
+
+	enum ParamIds { NUM_PARAMS };
+	enum InputIds { NUM_INPUTS };
+	enum OutputIds { ENUMS(TRIG_OUTPUT, NUM_CABLES), ENUMS(CV_OUTPUT, NUM_CABLES), NUM_OUTPUTS };
+	enum LightIds { NUM_LIGHTS };
+
+	/** Number of slots of the window, the next expander starts right after it */
+	int width = MAX_WIDTH;
+	/** Slots of the window which exist, the window of the last expander may be cut off */
+	int numSlots;
+	ExpanderChannels<MAX_WIDTH / 4> channels;
+
+	OscelotExpanderPoly() {
+		config(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS);
+		for (int i = 0; i < NUM_CABLES; i++) {
+			configOutput(TRIG_OUTPUT + i, string::f("Triggers of slots %d to %d", 16 * i + 1, 16 * i + 16));
+			configOutput(CV_OUTPUT + i, string::f("CVs of slots %d to %d", 16 * i + 1, 16 * i + 16));
+		}
+		onReset();
+	}
+
+	void onReset() override {
+		channels.reset();
+		for (int i = 0; i < NUM_OUTPUTS; i++) outputs[i].clearVoltages();
+		expanderId = 0;
+		numSlots = 0;
+		valuesVersion = 0;
+		connected = false;
+		connectedOutputs = 0;
+		expanderMessages.attach(rightExpander);
+	}
+
+	void process(const ProcessArgs& args) override {
+		ExpanderMessage* message = getMessage();
+		if (!message) {
+			if (connected) onReset();
+			return;
+		}
+		connected = true;
+
+		int slots = clamp(MAX_EXPANDER_SLOTS - message->expanderId, 0, width);
+		bool moved = message->expanderId != expanderId || slots != numSlots;
+		if (moved) {
+			expanderId = message->expanderId;
+			numSlots = slots;
+			channels.reset();
+		}
+
+		// Slots come in multiples of 8 as every expander covers a multiple of 8
+		int numVectors = numSlots / 4;
+		if (moved || message->valuesVersion != valuesVersion) {
+			channels.receive(message->values + expanderId, numVectors, args.sampleRate, smoothing);
+			valuesVersion = message->valuesVersion;
+		}
+
+		if (outputsPlugged()) channels.refresh();
+		if (channels.process(numVectors, args.sampleTime, getLowVoltage(), getVoltageRange())) {
+			for (int i = 0; i < NUM_CABLES; i++) {
+				int cableSlots = clamp(numSlots - 16 * i, 0, 16);
+				outputs[TRIG_OUTPUT + i].setChannels(cableSlots);
+				outputs[CV_OUTPUT + i].setChannels(cableSlots);
+			}
+			for (int c = 0; c < numVectors; c++) {
+				outputs[TRIG_OUTPUT + c / 4].setVoltageSimd(channels.trig[c], 4 * (c % 4));
+				outputs[CV_OUTPUT + c / 4].setVoltageSimd(channels.cv[c], 4 * (c % 4));
+			}
+		}
+
+		expSend(message, expanderId + width);
+	}
+
+	json_t* dataToJson() override {
+		json_t* rootJ = ExpanderModule::dataToJson();
+		json_object_set_new(rootJ, "width", json_integer(width));
+		return rootJ;
+	}
+
+	void dataFromJson(json_t* rootJ) override {
+		ExpanderModule::dataFromJson(rootJ);
+		json_t* widthJ = json_object_get(rootJ, "width");
+		if (widthJ) width = clamp((int)json_integer_value(widthJ) / 16 * 16, 16, MAX_WIDTH);
+	}
+};
+
+/** Slot ranges of the cables */
+struct OscPolyLabelWidget : widget::OpaqueWidget {
+	OscelotExpanderPoly* module;
+	OscelotTextLabel* windowLabel;
+	OscelotTextLabel* labelWidgets[OscelotExpanderPoly::NUM_CABLES];
+	int expanderId = -1;
+	int numSlots = -1;
+
+	void step() override {
+		if (!module) return;
+		if (module->expanderId == expanderId && module->numSlots == numSlots) return;
+		expanderId = module->expanderId;
+		numSlots = module->numSlots;
+
+		windowLabel->text = numSlots > 0 ? string::f("%03d-%03d", expanderId + 1, expanderId + numSlots) : "NONE";
+		for (int i = 0; i < OscelotExpanderPoly::NUM_CABLES; i++) {
+			int first = 16 * i;
+			int last = std::min(numSlots, first + 16);
+			labelWidgets[i]->text = first < last ? string::f("%03d-%03d", expanderId + first + 1, expanderId + last) : "";
+		}
+	}
+
+	void setLabels() {
+		clearChildren();
+
+		Vec lblPos = box.pos;
+		windowLabel = createWidget<OscelotTextLabel>(lblPos);
+		windowLabel->box.size = mm2px(Vec(25.4, 1));
+		addChild(windowLabel);
+		lblPos = lblPos.plus(Vec(0.0f, 16.0f));
+
+		for (int i = 0; i < OscelotExpanderPoly::NUM_CABLES; i++) {
+			lblPos = lblPos.plus(Vec(0.0f, 36.0f));
+			OscelotTextLabel* l = createWidget<OscelotTextLabel>(lblPos);
+			l->box.size = mm2px(Vec(25.4, 1));
+			addChild(l);
+			labelWidgets[i] = l;
+		}
+	}
+};
+
+struct OscelotExpanderPolyWidget : ThemedModuleWidget<OscelotExpanderPoly> {
+	OscelotExpanderPolyWidget(OscelotExpanderPoly* module) : ThemedModuleWidget<OscelotExpanderPoly>(module, "OscelotExpander", "Oscelot.md#poly-expander") {
+		setModule(module);
+
+		addChild(createWidget<PawScrew>(Vec(2 * RACK_GRID_WIDTH, 0)));
+		addChild(createWidget<PawScrew>(Vec(box.size.x - 3 * RACK_GRID_WIDTH, RACK_GRID_HEIGHT - RACK_GRID_WIDTH)));
+
+		OscPolyLabelWidget* oscLabelWidget = createWidget<OscPolyLabelWidget>(mm2px(Vec(0, 7)));
+		oscLabelWidget->module = module;
+		if (module) {
+			oscLabelWidget->setLabels();
+		}
+		addChild(oscLabelWidget);
+
+		// Same rows as the individual outputs of the 8-slot expander
+		Vec gatePos = mm2px(Vec(7, 14)).plus(Vec(0.0f, 16.0f));
+		Vec cvPos = mm2px(Vec(18.4, 14)).plus(Vec(0.0f, 16.0f));
+		for (int i = 0; i < OscelotExpanderPoly::NUM_CABLES; i++) {
+			gatePos = gatePos.plus(Vec(0.0f, 36.0f));
+			cvPos = cvPos.plus(Vec(0.0f, 36.0f));
+			addOutput(createOutputCentered<PawPort>(gatePos, module, OscelotExpanderPoly::TRIG_OUTPUT + i));
+			addOutput(createOutputCentered<PawPort>(cvPos, module, OscelotExpanderPoly::CV_OUTPUT + i));
+		}
+	}
+
+	void appendContextMenu(Menu* menu) override {
+		ThemedModuleWidget<OscelotExpanderPoly>::appendContextMenu(menu);
+		assert(module);
+
+		menu->addChild(new MenuSeparator());
+		menu->addChild(createSubmenuItem(string::f("Slots (%d)", module->width), "", [=](Menu* menu) {
+			for (int width : {16, 32, 64, 128}) {
+				menu->addChild(createCheckMenuItem(
+					string::f("%d slots on %d cables", width, width / 16), "", [=]() { return module->width == width; },
+					[=]() { module->width = width; }));
+			}
+		}));
+		appendExpanderMenu(menu, module);
+	}
+};
+}  // namespace Oscelot
+}  // namespace TheModularMind
+
+Model* modelOscelotExpanderPoly = createModel<TheModularMind::Oscelot::OscelotExpanderPoly, TheModularMind::Oscelot::OscelotExpanderPolyWidget>("OSCelotExpanderPoly");
@@ -0,0 +1,308 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "MeowMory.hpp"
+
+namespace TheModularMind {
+
+/** Mapping slots of one bank compiled into the layout of the module, ready to be swapped in */
+struct StagedBank {
+	/** Version of the bank storage the table corresponds to */
+	uint32_t version = 0;
+	/** Number of slots, the same as the mapping table of the module when the bank was staged */
+	int capacity = 0;
+	std::vector<int64_t> moduleIds;
+	std::vector<int> paramIds;
+	std::vector<OscController> controllers;
+	std::vector<uint8_t> hasController;
+	std::vector<std::string> labels;
+	std::vector<std::string> expLabels;
+
+	StagedBank(int capacity) { resize(capacity); }
+
+	/** Adds empty slots, allocates */
+	void resize(int capacity) {
+		if (capacity <= this->capacity) return;
+		this->capacity = capacity;
+		moduleIds.resize(capacity, -1);
+		paramIds.resize(capacity, 0);
+		controllers.resize(capacity);
+		hasController.resize(capacity, false);
+		labels.resize(capacity);
+		expLabels.resize(capacity, "None");
+	}
+
+	void fromBankMeowMory(const BankMeowMory& meowMory) {
+		int id = 0;
+		for (const BankMeowMoryParam& param : meowMory.bankParamArray) {
+			if (id >= capacity) break;
+			moduleIds[id] = param.moduleId;
+			paramIds[id] = param.paramId;
+			labels[id] = param.label;
+			if (param.controllerId >= 0) {
+				hasController[id] = controllers[id].init(param.address, param.controllerId, param.controllerMode);
+				if (hasController[id]) {
+					expLabels[id] = string::f("%s-%02d", controllers[id].getTypeString(), controllers[id].getControllerId());
+					if (param.encSensitivity) controllers[id].setSensitivity(param.encSensitivity);
+				}
+			}
+			id++;
+		}
+	}
+
+	/** Same layout as a bank saved from the module: all slots up to the last used one plus an empty one */
+	void toBankMeowMory(BankMeowMory& meowMory) {
+		int len;
+		for (len = capacity; len > 0; len--) {
+			if (moduleIds[len - 1] >= 0 || hasController[len - 1]) break;
+		}
+		if (len < capacity) len++;
+
+		meowMory.bankParamArray.clear();
+		for (int id = 0; id < len; id++) {
+			BankMeowMoryParam param;
+			if (moduleIds[id] >= 0) {
+				param.moduleId = moduleIds[id];
+				param.paramId = paramIds[id];
+			}
+			param.label = labels[id];
+			if (hasController[id]) {
+				param.controllerId = controllers[id].getControllerId();
+				param.address = controllers[id].getAddress();
+				param.controllerMode = controllers[id].getControllerMode();
+				if (controllers[id].getSensitivity() != OscController::ENCODER_DEFAULT_SENSITIVITY) param.encSensitivity = controllers[id].getSensitivity();
+			}
+			meowMory.bankParamArray.push_back(param);
+		}
+	}
+};
+
+/**
+ * Keeps a StagedBank of every bank compiled on a background thread, so the engine thread can
+ * switch banks by taking a table and swapping it with its slots. The table left holding the
+ * previous bank is handed back with retire() and written to the bank storage by the stager.
+ * Every write of the storage by others has to happen under getMutex() followed by invalidate().
+ * Banks are staged with the number of slots given by setCapacity().
+ */
+struct BankStager {
+	typedef StagedBank Bank;
+	static const int NUM_BANKS = 128;
+	static const uint32_t DISPOSE_CAPACITY = 256;
+
+	/** Called on every cycle of the stager thread, for other housekeeping of the module */
+	std::function<void()> idleCallback;
+
+	BankStager(BankMeowMory* storage) : storage(storage) {
+		for (int index = 0; index < NUM_BANKS; index++) {
+			staged[index] = nullptr;
+			retired[index] = nullptr;
+			versions[index] = 0;
+			stagedVersions[index] = 0;
+			stagedCapacities[index] = 0;
+		}
+	}
+
+	~BankStager() {
+		stop();
+		for (int index = 0; index < NUM_BANKS; index++) {
+			delete staged[index].exchange(nullptr);
+			delete retired[index].exchange(nullptr);
+		}
+		Bank* bank;
+		while (popDisposed(bank)) delete bank;
+	}
+
+	void start() {
+		if (running) return;
+		running = true;
+		stagerThread = std::thread([this] { this->stagerProcess(); });
+	}
+
+	void stop() {
+		{
+			std::lock_guard<std::mutex> lock(waitMutex);
+			running = false;
+		}
+		condition.notify_one();
+		if (stagerThread.joinable()) stagerThread.join();
+	}
+
+	std::mutex& getMutex() { return mutex; }
+
+	/** Marks the storage of a bank as changed, the table staged before is not used anymore */
+	void invalidate(int index) {
+		versions[index]++;
+		condition.notify_one();
+	}
+
+	void invalidateAll() {
+		for (int index = 0; index < NUM_BANKS; index++) versions[index]++;
+		condition.notify_one();
+	}
+
+	/** Slots of the banks staged from now on, banks staged before are staged again */
+	void setCapacity(int capacity) {
+		this->capacity = capacity;
+		condition.notify_one();
+	}
+
+	/** The bank currently applied to the module isn't staged */
+	void setActiveBank(int index) { activeBank = index; }
+
+	/**
+	 * Engine thread: takes the table of a bank with the given number of slots, nullptr if none is
+	 * ready. Tables with fewer slots are left to the stager, which stages the bank again.
+	 */
+	Bank* take(int index, int capacity) {
+		uint32_t version = versions[index];
+		Bank* bank = retired[index].exchange(nullptr);
+		if (bank && bank->version != version) {
+			dispose(bank);
+			bank = nullptr;
+		}
+		if (bank && bank->capacity != capacity) {
+			// Saved to the storage by the stager first, only the engine thread retires banks
+			retired[index].exchange(bank);
+			return nullptr;
+		}
+		if (!bank) {
+			bank = staged[index].exchange(nullptr);
+			if (bank && bank->version != version) {
+				dispose(bank);
+				bank = nullptr;
+			}
+			if (bank && bank->capacity != capacity) {
+				Bank* expected = nullptr;
+				if (!staged[index].compare_exchange_strong(expected, bank)) dispose(bank);
+				return nullptr;
+			}
+		}
+		return bank;
+	}
+
+	/** The staged table of a bank is up to date and has the given number of slots, e.g. for tools waiting for the stager */
+	bool isStaged(int index, int capacity) const {
+		return staged[index].load() && stagedVersions[index] == versions[index] && stagedCapacities[index] == capacity;
+	}
+
+	/** Engine thread: hands over a table holding the slots of a bank which has just been left */
+	void retire(Bank* bank, int index) {
+		// The table is newer than the bank storage from now on
+		bank->version = ++versions[index];
+		Bank* previous = retired[index].exchange(bank);
+		if (previous) dispose(previous);
+	}
+
+	/** Writes the retired tables to the storage right away, used before the storage is serialized */
+	void flushRetired() {
+		std::lock_guard<std::mutex> lock(mutex);
+		for (int index = 0; index < NUM_BANKS; index++) {
+			// Taken while writing, a retired bank can't be retired again before the engine thread took it
+			Bank* bank = retired[index].exchange(nullptr);
+			if (!bank) continue;
+			if (bank->version == versions[index]) bank->toBankMeowMory(storage[index]);
+			retired[index].exchange(bank);
+		}
+	}
+
+   private:
+	BankMeowMory* storage;
+	std::mutex mutex;
+	std::atomic<Bank*> staged[NUM_BANKS];
+	std::atomic<Bank*> retired[NUM_BANKS];
+	std::atomic<uint32_t> versions[NUM_BANKS];
+	/** Version of the table last published in staged, written by the stager thread */
+	std::atomic<uint32_t> stagedVersions[NUM_BANKS];
+	/** Slots of the table last published in staged, it is staged again after the capacity grew */
+	std::atomic<int> stagedCapacities[NUM_BANKS];
+	std::atomic<int> activeBank{0};
+	std::atomic<int> capacity{0};
+
+	/** Tables dropped by the engine thread, single producer single consumer */
+	Bank* disposed[DISPOSE_CAPACITY];
+	std::atomic<uint32_t> disposeHead{0};
+	std::atomic<uint32_t> disposeTail{0};
+
+	std::thread stagerThread;
+	std::mutex waitMutex;
+	std::condition_variable condition;
+	bool running = false;
+
+	void dispose(Bank* bank) {
+		uint32_t head = disposeHead.load(std::memory_order_relaxed);
+		// Leaked if the stager thread is stuck, never blocks the engine thread
+		if (head - disposeTail.load(std::memory_order_acquire) >= DISPOSE_CAPACITY) return;
+		disposed[head % DISPOSE_CAPACITY] = bank;
+		disposeHead.store(head + 1, std::memory_order_release);
+	}
+
+	bool popDisposed(Bank*& bank) {
+		uint32_t tail = disposeTail.load(std::memory_order_relaxed);
+		if (tail == disposeHead.load(std::memory_order_acquire)) return false;
+		bank = disposed[tail % DISPOSE_CAPACITY];
+		disposeTail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	void publish(int index, Bank* bank) {
+		stagedVersions[index] = bank->version;
+		stagedCapacities[index] = bank->capacity;
+		delete staged[index].exchange(bank);
+	}
+
+	/** Writes a retired table to the bank storage and keeps it as the staged table of the bank */
+	void saveRetired(int index) {
+		Bank* bank;
+		{
+			// Under the mutex so an engine thread falling back to the storage sees the saved bank
+			std::lock_guard<std::mutex> lock(mutex);
+			bank = retired[index].exchange(nullptr);
+			if (!bank) return;
+			if (bank->version != versions[index]) {
+				delete bank;
+				return;
+			}
+			bank->toBankMeowMory(storage[index]);
+		}
+		publish(index, bank);
+	}
+
+	void stage(int index) {
+		if (index == activeBank || retired[index].load()) return;
+		if (staged[index].load() && stagedVersions[index] == versions[index] && stagedCapacities[index] >= capacity) return;
+
+		BankMeowMory meowMory;
+		uint32_t version;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			version = versions[index];
+			meowMory = storage[index];
+		}
+		Bank* bank = new Bank(capacity);
+		bank->version = version;
+		bank->fromBankMeowMory(meowMory);
+		publish(index, bank);
+	}
+
+	void stagerProcess() {
+		while (true) {
+			{
+				std::unique_lock<std::mutex> lock(waitMutex);
+				condition.wait_for(lock, std::chrono::milliseconds(20));
+				if (!running) break;
+			}
+			Bank* bank;
+			while (popDisposed(bank)) delete bank;
+			for (int index = 0; index < NUM_BANKS; index++) saveRetired(index);
+			for (int index = 0; index < NUM_BANKS; index++) stage(index);
+			if (idleCallback) idleCallback();
+		}
+	}
+};
+
+}  // namespace TheModularMind
@@ -0,0 +1,282 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include "../osc/OscController.hpp"
+
+namespace TheModularMind {
+
+/** Snapshot of the OSC controllers of all mapping slots, never changed once published */
+struct MappingTable {
+	uint64_t version = 0;
+	/** Number of slots, grows with the slots of the module */
+	const int capacity;
+	/** Number of maps */
+	int mapLen = 1;
+	OscController** controllers;
+
+	// Reclamation, only used by MappingTables
+	uint64_t retireEpoch = 0;
+	int numDropped = 0;
+	OscController** dropped;
+	MappingTable* nextRetired = nullptr;
+
+	MappingTable(int capacity) : capacity(capacity) {
+		controllers = new OscController*[capacity];
+		dropped = new OscController*[capacity];
+		std::fill(controllers, controllers + capacity, nullptr);
+	}
+
+	~MappingTable() {
+		delete[] controllers;
+		delete[] dropped;
+	}
+
+	MappingTable(const MappingTable&) = delete;
+	MappingTable& operator=(const MappingTable&) = delete;
+};
+
+/**
+ * Read-copy-update of the mapping table: a writer copies the current table, changes the copy
+ * and publishes it with an atomic swap, so readers always see a complete table without locking.
+ * Writers are serialized by the write mutex, the engine thread only ever tries to lock it.
+ * Replaced tables and the controllers they dropped are freed by collect() once every online
+ * reader thread has passed a quiescent state, i.e. holds no pointer loaded before the swap.
+ * Controllers are plain data taken from a pool owned by the tables and are never deleted. The
+ * pool and the spare table are refilled by collect(), writers on the engine thread check
+ * available() and hasSpare() first so nothing is allocated there.
+ */
+struct MappingTables {
+	typedef MappingTable Table;
+	enum Reader { READER_ENGINE, READER_UI, NUM_READERS };
+
+	MappingTables(int capacity) : capacity(capacity) {
+		grow(poolSize(capacity));
+		current = new Table(capacity);
+		spare = new Table(capacity);
+		for (int reader = 0; reader < NUM_READERS; reader++) readerEpochs[reader] = 0;
+	}
+
+	~MappingTables() {
+		delete current.load();
+		delete spare.load();
+		for (Table* retired = retiredHead.exchange(nullptr); retired;) {
+			Table* next = retired->nextRetired;
+			pending.push_back(retired);
+			retired = next;
+		}
+		for (Table* retired : pending) free(retired);
+		for (PoolNode* block : blocks) delete[] block;
+	}
+
+	const Table* get() const { return current.load(); }
+
+	std::mutex& getWriteMutex() { return writeMutex; }
+
+	/**
+	 * Number of slots of the tables from the next edit() on, tables only grow. The caller holds
+	 * the write mutex and grows the slots of the module first.
+	 */
+	void setCapacity(int capacity) {
+		if (capacity <= this->capacity) return;
+		this->capacity = capacity;
+		int size = poolSize(capacity);
+		if (size > poolCapacity) grow(size - poolCapacity);
+	}
+
+	int getCapacity() const { return capacity; }
+
+	/** Controllers left in the pool, writers on the engine thread wait for collect() if it's too few */
+	int available() const { return freeCount.load(); }
+
+	/** Whether edit() can return the preallocated table, writers on the engine thread check it first */
+	bool hasSpare() const {
+		const Table* table = spare.load();
+		return table && table->capacity == capacity;
+	}
+
+	/** Copy of the current table to change and publish, the caller holds the write mutex */
+	Table* edit() {
+		Table* table = spare.exchange(nullptr);
+		if (table && table->capacity != capacity) {
+			// Only right after the tables have grown
+			delete table;
+			table = nullptr;
+		}
+		if (!table) table = new Table(capacity);
+		const Table* base = get();
+		table->version = base->version + 1;
+		table->mapLen = base->mapLen;
+		std::fill(std::copy(base->controllers, base->controllers + base->capacity, table->controllers), table->controllers + capacity, nullptr);
+		table->numDropped = 0;
+		table->nextRetired = nullptr;
+		return table;
+	}
+
+	/**
+	 * Controller from the pool with a new serial, nullptr if the address isn't supported. The
+	 * caller holds the write mutex.
+	 */
+	OscController* createController(const std::string& address, int controllerId, CONTROLLERMODE controllerMode = CONTROLLERMODE::DIRECT) {
+		PoolNode* node = allocate();
+		if (!node->controller.init(address, controllerId, controllerMode)) {
+			release(node);
+			return nullptr;
+		}
+		node->controller.serial = nextSerial++;
+		return &node->controller;
+	}
+
+	/** Copy as a new controller with a new serial, its values start over */
+	OscController* copyController(const OscController& controller) {
+		PoolNode* node = allocate();
+		node->controller = controller;
+		node->controller.serial = nextSerial++;
+		return &node->controller;
+	}
+
+	/**
+	 * Controller of a slot of an edited table which may be changed: published controllers are
+	 * replaced by a copy first, as the engine thread keeps reading them. The copy keeps the
+	 * serial, so the values of the controller are kept.
+	 */
+	OscController* modifyController(Table* table, int id) {
+		OscController* controller = table->controllers[id];
+		if (!controller || controller != get()->controllers[id]) return controller;
+		table->controllers[id] = copyController(*controller);
+		table->controllers[id]->serial = controller->serial;
+		return table->controllers[id];
+	}
+
+	/**
+	 * Publishes a changed copy, the caller holds the write mutex. Controllers which are no longer
+	 * part of the table go back to the pool with the old one.
+	 */
+	void publish(Table* table) {
+		Table* old = current.exchange(table);
+		old->numDropped = 0;
+		for (int id = 0; id < old->capacity; id++) {
+			if (old->controllers[id] && old->controllers[id] != table->controllers[id]) old->dropped[old->numDropped++] = old->controllers[id];
+		}
+		old->retireEpoch = epoch.fetch_add(1);
+		old->nextRetired = retiredHead.load();
+		while (!retiredHead.compare_exchange_weak(old->nextRetired, old)) {
+		}
+	}
+
+	/** Readers which are offline, e.g. the UI in headless mode, don't hold back reclamation */
+	void setOnline(Reader reader, bool online) { readerEpochs[reader] = online ? epoch.load() : 0; }
+
+	/** Called by a reader thread at a point where it holds no table or controller pointers */
+	void quiescent(Reader reader) { readerEpochs[reader] = epoch.load(); }
+
+	/** Frees the retired tables no reader can access anymore, called regularly by a background thread */
+	void collect() {
+		for (Table* retired = retiredHead.exchange(nullptr); retired;) {
+			Table* next = retired->nextRetired;
+			pending.push_back(retired);
+			retired = next;
+		}
+		uint64_t safeEpoch = UINT64_MAX;
+		for (int reader = 0; reader < NUM_READERS; reader++) {
+			uint64_t readerEpoch = readerEpochs[reader];
+			if (readerEpoch > 0) safeEpoch = std::min(safeEpoch, readerEpoch);
+		}
+		for (auto it = pending.begin(); it != pending.end();) {
+			if ((*it)->retireEpoch < safeEpoch) {
+				free(*it);
+				it = pending.erase(it);
+			} else {
+				it++;
+			}
+		}
+		// Keeps enough controllers for a bank switch while the readers hold back replaced tables
+		int missing = poolReserve(capacity) - freeCount.load();
+		if (missing > 0) grow(std::max(missing, (int)capacity));
+		if (!spare.load()) {
+			Table* table = new Table(capacity);
+			Table* expected = nullptr;
+			if (!spare.compare_exchange_strong(expected, table)) delete table;
+		}
+	}
+
+   private:
+	struct PoolNode {
+		OscController controller;
+		PoolNode* next;
+	};
+
+	/** Free controllers, popped by writers only and pushed by collect(), so there is no ABA */
+	std::atomic<PoolNode*> freeHead{nullptr};
+	std::atomic<int> freeCount{0};
+	/** Serializes growing by writers and by collect() */
+	std::mutex poolMutex;
+	std::vector<PoolNode*> blocks;
+
+	/** Number of slots of new tables, only changed under the write mutex */
+	std::atomic<int> capacity;
+	/** Controllers in the pool */
+	std::atomic<int> poolCapacity{0};
+
+	/** Serial of the next new controller, only used under the write mutex */
+	uint32_t nextSerial = 1;
+
+	std::atomic<Table*> current;
+	/** Preallocated table for the next edit() so writers on the engine thread don't allocate */
+	std::atomic<Table*> spare;
+	std::atomic<Table*> retiredHead{nullptr};
+	std::atomic<uint64_t> epoch{1};
+	/** Epoch of the last quiescent state of each reader, 0 if offline */
+	std::atomic<uint64_t> readerEpochs[NUM_READERS];
+	std::mutex writeMutex;
+	/** Retired tables waiting for the readers, only used by collect() */
+	std::vector<Table*> pending;
+
+	/** Enough for a full table plus the controllers of a few replaced ones waiting for the readers */
+	static int poolSize(int capacity) { return 4 * capacity; }
+	/** Free controllers collect() keeps in the pool */
+	static int poolReserve(int capacity) { return 2 * capacity; }
+
+	/** Never called on the engine thread */
+	void grow(int size) {
+		std::lock_guard<std::mutex> lock(poolMutex);
+		PoolNode* block = new PoolNode[size];
+		blocks.push_back(block);
+		poolCapacity += size;
+		for (int i = 0; i < size; i++) release(&block[i]);
+	}
+
+	PoolNode* allocate() {
+		PoolNode* node = freeHead.load();
+		while (node && !freeHead.compare_exchange_weak(node, node->next)) {
+		}
+		if (node) {
+			freeCount--;
+			return node;
+		}
+		// Only writers outside of the engine thread get here, those on the engine thread check available()
+		grow(capacity);
+		return allocate();
+	}
+
+	void release(PoolNode* node) {
+		node->next = freeHead.load();
+		while (!freeHead.compare_exchange_weak(node->next, node)) {
+		}
+		freeCount++;
+	}
+
+	void release(OscController* controller) {
+		// The controller is the first member of its node
+		release(reinterpret_cast<PoolNode*>(controller));
+	}
+
+	void free(Table* table) {
+		for (int i = 0; i < table->numDropped; i++) release(table->dropped[i]);
+		delete table;
+	}
+};
+
+}  // namespace TheModularMind
@@ -1,4 +1,6 @@
 #pragma once
+#include <unordered_map>
+#include <vector>
 #include "../osc/OscController.hpp"
 
 namespace TheModularMind {
@@ -111,6 +113,58 @@ struct ModuleMeowMory {
 	}
 };
 
+/**
+ * Stored module mappings by model, rebuilt when the storage has changed, so scanning the modules
+ * of a patch needs neither key strings nor map lookups. Each entry is a plan for applyMappings()
+ * which only lacks the id of the module.
+ */
+struct ModuleMeowMoryIndex {
+	void invalidate() {
+		valid = false;
+		version++;
+	}
+
+	/** Changes with every change of the storage */
+	uint32_t getVersion() const { return version; }
+
+	/** Mappings prepared for the model, nullptr if no mapping is stored for it */
+	std::vector<BankMeowMoryParam>* find(const std::map<std::string, ModuleMeowMory>& storage, Model* model) {
+		if (!valid) rebuild(storage);
+		auto it = plans.find(model);
+		return it != plans.end() ? &it->second : nullptr;
+	}
+
+	/** Sets the module of a plan, mappings without a parameter stay unbound */
+	static void bind(std::vector<BankMeowMoryParam>& plan, int64_t moduleId) {
+		for (BankMeowMoryParam& mapping : plan) mapping.moduleId = mapping.paramId >= 0 ? moduleId : -1;
+	}
+
+   private:
+	bool valid = false;
+	uint32_t version = 0;
+	std::unordered_map<Model*, std::vector<BankMeowMoryParam>> plans;
+
+	void rebuild(const std::map<std::string, ModuleMeowMory>& storage) {
+		plans.clear();
+		for (auto& it : storage) {
+			// Keys are "<plugin slug> <module slug>", slugs contain no spaces
+			size_t separator = it.first.find(' ');
+			if (separator == std::string::npos) continue;
+			// Models of plugins which aren't installed can't be in the patch
+			Model* model = plugin::getModel(it.first.substr(0, separator), it.first.substr(separator + 1));
+			if (!model) continue;
+			std::vector<BankMeowMoryParam>& plan = plans[model];
+			plan.reserve(it.second.paramArray.size());
+			for (const ModuleMeowMoryParam& meowMoryParam : it.second.paramArray) {
+				BankMeowMoryParam mapping;
+				static_cast<ModuleMeowMoryParam&>(mapping) = meowMoryParam;
+				plan.push_back(mapping);
+			}
+		}
+		valid = true;
+	}
+};
+
 struct BankMeowMory {
 	std::list<BankMeowMoryParam> bankParamArray;
 
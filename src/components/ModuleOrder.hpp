@@ -0,0 +1,88 @@
+#pragma once
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+namespace TheModularMind {
+
+/**
+ * Modules with stored mappings in the order of the rack, top to bottom and left to right, for
+ * stepping through them with PREV/NEXT. The order is only rebuilt after modules have been added,
+ * removed or moved, which is detected by a signature of the module container on every frame.
+ */
+struct ModuleOrder {
+	/** Called on every frame, neither allocates nor sorts */
+	void check(const std::list<Widget*>& children) {
+		uint64_t hash = 14695981039346656037ULL;
+		for (Widget* w : children) {
+			hash = mix(hash, (uint64_t)(uintptr_t)w);
+			uint32_t x, y;
+			std::memcpy(&x, &w->box.pos.x, sizeof(x));
+			std::memcpy(&y, &w->box.pos.y, sizeof(y));
+			hash = mix(hash, ((uint64_t)y << 32) | x);
+		}
+		if (hash != signature) {
+			signature = hash;
+			valid = false;
+		}
+	}
+
+	void invalidate() { valid = false; }
+
+	bool isValid() const { return valid; }
+
+	void rebuild(const std::list<Widget*>& children, std::function<bool(Module*)> hasMapping) {
+		entries.clear();
+		positions.clear();
+		for (Widget* w : children) {
+			ModuleWidget* mw = dynamic_cast<ModuleWidget*>(w);
+			if (!mw || !mw->module) continue;
+			positions[mw->module->id] = mw->box.pos;
+			if (hasMapping(mw->module)) entries.push_back(Entry{mw->box.pos.y, mw->box.pos.x, mw->module});
+		}
+		std::sort(entries.begin(), entries.end());
+		valid = true;
+	}
+
+	/** Module with stored mappings following the given one, wrapping around, nullptr if there is none */
+	Module* next(int64_t moduleId) const {
+		if (entries.empty()) return nullptr;
+		auto it = positions.find(moduleId);
+		if (it == positions.end()) return entries.front().module;
+		auto next = std::upper_bound(entries.begin(), entries.end(), Entry{it->second.y, it->second.x, nullptr});
+		return next != entries.end() ? next->module : entries.front().module;
+	}
+
+	/** Module with stored mappings preceding the given one, wrapping around, nullptr if there is none */
+	Module* prev(int64_t moduleId) const {
+		if (entries.empty()) return nullptr;
+		auto it = positions.find(moduleId);
+		if (it == positions.end()) return entries.back().module;
+		auto prev = std::lower_bound(entries.begin(), entries.end(), Entry{it->second.y, it->second.x, nullptr});
+		return prev != entries.begin() ? (prev - 1)->module : entries.back().module;
+	}
+
+   private:
+	struct Entry {
+		float y;
+		float x;
+		Module* module;
+		bool operator<(const Entry& other) const { return y < other.y || (y == other.y && x < other.x); }
+	};
+
+	bool valid = false;
+	uint64_t signature = 0;
+	/** Modules with stored mappings, sorted */
+	std::vector<Entry> entries;
+	/** Positions of all modules, the current one may have no stored mapping anymore */
+	std::unordered_map<int64_t, Vec> positions;
+
+	static uint64_t mix(uint64_t hash, uint64_t value) {
+		hash ^= value;
+		return hash * 1099511628211ULL;
+	}
+};
+
+}  // namespace TheModularMind
@@ -78,13 +78,16 @@ struct OscelotParam {
 		value = f;
 	}
 
-	void process(float sampleTime = -1.f, bool force = false) {
-		if (valueOut == std::numeric_limits<float>::infinity()) return;
+	/** Returns true if a new value has been written to the parameter */
+	bool process(float sampleTime = -1.f, bool force = false) {
+		if (valueOut == std::numeric_limits<float>::infinity()) return false;
 
 		if (valueOut != value || force) {
 			paramQuantity->setScaledValue(value);
 			valueOut = value;
+			return true;
 		}
+		return false;
 	}
 
 	float getValue() {
@@ -0,0 +1,77 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace TheModularMind {
+
+/**
+ * Growable storage of per-slot data. Slots are allocated in blocks which never move, so
+ * references to slots stay valid and other threads index the storage without locking while it
+ * grows. Only growing is serialized, the storage never shrinks. Replaced block directories are
+ * kept until destruction as readers may still use them, together they are smaller than the
+ * current one.
+ */
+template <typename T, int BLOCK_SIZE = 32>
+struct SlotStorage {
+	SlotStorage() {
+		Directory* initial = new Directory;
+		directories.push_back(initial);
+		directory = initial;
+	}
+
+	~SlotStorage() {
+		const Directory* current = directory.load();
+		for (int block = 0; block < size() / BLOCK_SIZE; block++) delete[] current->blocks[block];
+		for (Directory* replaced : directories) delete replaced;
+	}
+
+	/** Number of slots, a multiple of BLOCK_SIZE */
+	int size() const { return count.load(std::memory_order_acquire); }
+
+	T& operator[](int id) { return directory.load(std::memory_order_acquire)->blocks[id / BLOCK_SIZE][id % BLOCK_SIZE]; }
+	const T& operator[](int id) const { return directory.load(std::memory_order_acquire)->blocks[id / BLOCK_SIZE][id % BLOCK_SIZE]; }
+
+	/**
+	 * Grows the storage to hold at least size slots, init is called for every new slot before it
+	 * becomes visible through size(). Returns the previous size.
+	 */
+	template <typename INIT>
+	int grow(int size, INIT init) {
+		std::lock_guard<std::mutex> lock(growMutex);
+		int oldSize = count.load();
+		int numBlocks = (size + BLOCK_SIZE - 1) / BLOCK_SIZE;
+		int oldBlocks = oldSize / BLOCK_SIZE;
+		if (numBlocks <= oldBlocks) return oldSize;
+
+		Directory* current = directory.load();
+		if (numBlocks > (int)current->blocks.size()) {
+			Directory* bigger = new Directory;
+			bigger->blocks.resize(std::max(numBlocks, 2 * (int)current->blocks.size()), nullptr);
+			std::copy(current->blocks.begin(), current->blocks.end(), bigger->blocks.begin());
+			directories.push_back(bigger);
+			directory = bigger;
+			current = bigger;
+		}
+		for (int block = oldBlocks; block < numBlocks; block++) {
+			current->blocks[block] = new T[BLOCK_SIZE];
+			for (int i = 0; i < BLOCK_SIZE; i++) init(block * BLOCK_SIZE + i, current->blocks[block][i]);
+		}
+		count.store(numBlocks * BLOCK_SIZE, std::memory_order_release);
+		return oldSize;
+	}
+
+   private:
+	struct Directory {
+		std::vector<T*> blocks;
+	};
+
+	std::atomic<Directory*> directory;
+	std::atomic<int> count{0};
+	/** All directories ever used, the last one is current */
+	std::vector<Directory*> directories;
+	std::mutex growMutex;
+};
+
+}  // namespace TheModularMind
@@ -0,0 +1,74 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+
+namespace TheModularMind {
+
+/**
+ * Lock-free histogram of latencies in nanoseconds with logarithmic buckets, every octave
+ * is split into 8 linear sub-buckets (~12% resolution). Recorded from a single thread,
+ * read from any thread.
+ */
+struct LatencyHistogram {
+	static const int SUB_BUCKET_BITS = 3;
+	static const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+	/** Latencies below 2^MIN_BITS ns (~1us) are collected in the first bucket */
+	static const int MIN_BITS = 10;
+	static const int OCTAVES = 32;
+	static const int NUM_BUCKETS = OCTAVES * SUB_BUCKETS + 1;
+
+	std::atomic<uint32_t> buckets[NUM_BUCKETS];
+	std::atomic<uint64_t> count;
+	std::atomic<uint64_t> max;
+
+	LatencyHistogram() { reset(); }
+
+	/** Monotonic timestamp in nanoseconds, comparable between threads */
+	static int64_t now() { return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count(); }
+
+	static int getBucket(uint64_t ns) {
+		if (ns < (1ull << MIN_BITS)) return 0;
+		int msb = 63 - __builtin_clzll(ns);
+		int octave = msb - MIN_BITS;
+		if (octave >= OCTAVES) return NUM_BUCKETS - 1;
+		int sub = (ns >> (msb - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1);
+		return 1 + octave * SUB_BUCKETS + sub;
+	}
+
+	static uint64_t getBucketUpperBound(int bucket) {
+		if (bucket == 0) return 1ull << MIN_BITS;
+		int msb = (bucket - 1) / SUB_BUCKETS + MIN_BITS;
+		int sub = (bucket - 1) % SUB_BUCKETS;
+		return (1ull << msb) + ((uint64_t)(sub + 1) << (msb - SUB_BUCKET_BITS));
+	}
+
+	void record(uint64_t ns) {
+		buckets[getBucket(ns)].fetch_add(1, std::memory_order_relaxed);
+		count.fetch_add(1, std::memory_order_relaxed);
+		if (ns > max.load(std::memory_order_relaxed)) max.store(ns, std::memory_order_relaxed);
+	}
+
+	/** Returns the upper bound of the bucket containing the percentile p (0..1) in nanoseconds */
+	uint64_t getPercentile(float p) {
+		uint64_t total = 0;
+		for (int i = 0; i < NUM_BUCKETS; i++) total += buckets[i].load(std::memory_order_relaxed);
+		if (total == 0) return 0;
+
+		uint64_t target = std::max<uint64_t>(1, (uint64_t)(p * total + 0.5f));
+		uint64_t sum = 0;
+		for (int i = 0; i < NUM_BUCKETS; i++) {
+			sum += buckets[i].load(std::memory_order_relaxed);
+			if (sum >= target) return std::min(getBucketUpperBound(i), max.load(std::memory_order_relaxed));
+		}
+		return max;
+	}
+
+	void reset() {
+		for (int i = 0; i < NUM_BUCKETS; i++) buckets[i].store(0, std::memory_order_relaxed);
+		count = 0;
+		max = 0;
+	}
+};
+
+}  // namespace TheModularMind
@@ -20,6 +20,17 @@ class OscArgInt32 : public OscArg {
 	std::int32_t value;
 };
 
+class OscArgInt64 : public OscArg {
+   public:
+	OscArgInt64(std::int64_t value) : value(value) {}
+	osc::TypeTagValues getType() const override { return osc::INT64_TYPE_TAG; }
+	std::int64_t get() const { return value; }
+	void set(std::int64_t value) { this->value = value; }
+
+   private:
+	std::int64_t value;
+};
+
 class OscArgFloat : public OscArg {
    public:
 	OscArgFloat(float value) : value(value) {}
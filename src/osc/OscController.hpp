@@ -1,66 +1,155 @@
 #pragma once
-#include "../plugin.hpp"
+#include <cstdint>
+#include <cstring>
+#include <string>
 
 namespace TheModularMind {
 
 enum class CONTROLLERMODE { DIRECT = 0, PICKUP1 = 1, PICKUP2 = 2, TOGGLE = 3, TOGGLE_VALUE = 4 };
 
-class OscController {
-   public:
-	static OscController *Create(std::string address, int controllerId, CONTROLLERMODE controllerMode = CONTROLLERMODE::DIRECT, float value = -1.f, uint32_t ts = 0);
+/** Kind of OSC control, given by the end of its address */
+enum class CONTROLLERTYPE : uint8_t { FADER = 0, ENCODER = 1, BUTTON = 2 };
+
+/** State machine of the TOGGLE modes: a press switches on, the next press switches off */
+enum class TOGGLESTATE : uint8_t { IDLE = 0, PRESSED_ON = 1, RELEASED_ON = 2, PRESSED_OFF = 3 };
+
+/**
+ * Values received and sent for a mapped OSC control, kept per mapping slot by the engine thread
+ * as published controllers are never changed.
+ */
+struct OscControllerState {
+	/** Serial of the controller the values belong to, 0 for none */
+	uint32_t serial = 0;
+	/** Mode the toggle state belongs to */
+	CONTROLLERMODE controllerMode = CONTROLLERMODE::DIRECT;
+	TOGGLESTATE toggleState = TOGGLESTATE::IDLE;
+	uint32_t lastTs = 0;
+	float current = -1.f;
+	float lastValueIn = -1.f;
+	float lastValueIndicate = -1.f;
+	/** Hash of the display value sent last as feedback, 0 if nothing has been sent */
+	uint64_t lastValueOut = 0;
+
+	float getCurrentValue() const { return current; }
+	uint32_t getTs() const { return lastTs; }
+
+	void setValueIn(float value) { lastValueIn = value; }
+	float getValueIn() const { return lastValueIn; }
+	void setValueIndicate(float value) { lastValueIndicate = value; }
+	float getValueIndicate() const { return lastValueIndicate; }
+
+	/** Feedback is only sent when the display value of the parameter changes, compared by hash */
+	bool isValueOutChanged(uint64_t valueHash) const { return lastValueOut != valueHash; }
+	void setValueOut(uint64_t valueHash) { lastValueOut = valueHash; }
+	void resetValueOut() { lastValueOut = 0; }
+};
+
+/**
+ * Plain data of one mapped OSC control, copied by value and kept in pools and tables, the
+ * behaviour of the different types is selected by a switch on the type. The values it receives
+ * and sends are kept apart in an OscControllerState.
+ */
+struct OscController {
 	static const int ENCODER_DEFAULT_SENSITIVITY = 649;
+	static const int MAX_ADDRESS_LENGTH = 64;
+
+	CONTROLLERTYPE type;
+	CONTROLLERMODE controllerMode;
+	int controllerId;
+	int sensitivity;
+	/** Identifies the controller across the copies made to change its settings, 0 if not in a table */
+	uint32_t serial;
+	int addressLength;
+	char address[MAX_ADDRESS_LENGTH];
 
-	virtual ~OscController() {}
+	/** Sets up a controller for an address, false if the address has no known type or is too long */
+	bool init(const std::string &address, int controllerId, CONTROLLERMODE controllerMode = CONTROLLERMODE::DIRECT);
 
-	float getCurrentValue() { return current; }
+	/** Starts the values of the controller, optionally with a received value */
+	void initState(OscControllerState &state, float value = -1.f, uint32_t ts = 0) const {
+		state = OscControllerState();
+		state.serial = serial;
+		state.controllerMode = controllerMode;
+		if (type == CONTROLLERTYPE::ENCODER) {
+			setCurrentValue(state, value, ts);
+		} else {
+			state.current = value;
+			state.lastTs = ts;
+		}
+	}
 
-	virtual bool setCurrentValue(float value, uint32_t ts) {
-		current = value;
-		lastTs = ts;
-		return true;
+	/** Starts over values of another controller, a toggle restarts after the mode has been changed */
+	void updateState(OscControllerState &state) const {
+		if (state.serial != serial) initState(state);
+		if (state.controllerMode != controllerMode) {
+			state.controllerMode = controllerMode;
+			state.toggleState = TOGGLESTATE::IDLE;
+		}
 	}
 
-	void reset() {
-		controllerId = -1;
-		lastTs = 0;
-		current = -1.0f;
-		lastValueIn = -1.f;
-		lastValueIndicate = -1.f;
-		lastValueOut = -1.f;
+	bool setCurrentValue(OscControllerState &state, float value, uint32_t ts) const {
+		switch (type) {
+			case CONTROLLERTYPE::FADER:
+				if (ts == 0 || ts > state.lastTs) {
+					state.current = value;
+					state.lastTs = ts;
+					return true;
+				}
+				return false;
+			case CONTROLLERTYPE::ENCODER:
+				if (ts == 0) {
+					state.current = value;
+					state.lastTs = ts;
+				} else if (ts > state.lastTs) {
+					state.current = clampValue(state.current + value / float(sensitivity));
+					state.lastTs = ts;
+				}
+				return state.current >= 0.f;
+			case CONTROLLERTYPE::BUTTON:
+				if (ts == 0) {
+					state.current = value;
+					state.lastTs = ts;
+				} else if (ts > state.lastTs) {
+					state.current = clampValue(value);
+					state.lastTs = ts;
+				}
+				return state.current >= 0.f;
+		}
+		return false;
 	}
 
-	void resetValue() { current = -1.0f; }
-	virtual void setSensitivity(int sensitivity) {}
-	virtual int getSensitivity() { return ENCODER_DEFAULT_SENSITIVITY; }
-	int getControllerId() { return controllerId; }
-	void setControllerId(int controllerId) { this->controllerId = controllerId; }
-	void setTs(uint32_t ts) { this->lastTs = ts; }
-	uint32_t getTs() { return lastTs; }
-	void setAddress(std::string address) { this->address = address; }
-	std::string getAddress() { return address; }
-	const char *getTypeString() { return type; }
-	void setTypeString(const char *type) { this->type = type; }
+	void setSensitivity(int sensitivity) {
+		if (type == CONTROLLERTYPE::ENCODER) this->sensitivity = sensitivity;
+	}
+	int getSensitivity() const { return type == CONTROLLERTYPE::ENCODER ? sensitivity : ENCODER_DEFAULT_SENSITIVITY; }
+	int getControllerId() const { return controllerId; }
+	bool matches(int controllerId, const std::string &address) const {
+		return this->controllerId == controllerId && (int)address.size() == addressLength && std::memcmp(address.data(), this->address, addressLength) == 0;
+	}
+	std::string getAddress() const { return std::string(address, addressLength); }
+	const char *getTypeString() const {
+		switch (type) {
+			case CONTROLLERTYPE::FADER: return "FDR";
+			case CONTROLLERTYPE::ENCODER: return "ENC";
+			case CONTROLLERTYPE::BUTTON: return "BTN";
+		}
+		return "";
+	}
 	void setControllerMode(CONTROLLERMODE controllerMode) { this->controllerMode = controllerMode; }
-	CONTROLLERMODE getControllerMode() { return controllerMode; }
+	CONTROLLERMODE getControllerMode() const { return controllerMode; }
 
-	void setValueIn(float value) { lastValueIn = value; }
-	float getValueIn() { return lastValueIn; }
-	void setValueOut(std::string value) { lastValueOut = value; }
-	std::string getValueOut() { return lastValueOut; }
-	void setValueIndicate(float value) { lastValueIndicate = value; }
-	float getValueIndicate() { return lastValueIndicate; }
+	/** FNV-1a, never 0 for the short display strings of parameters */
+	static uint64_t hashValue(const std::string &value) {
+		uint64_t hash = 14695981039346656037ULL;
+		for (unsigned char c : value) {
+			hash ^= c;
+			hash *= 1099511628211ULL;
+		}
+		return hash;
+	}
 
    private:
-	int controllerId = -1;
-	uint32_t lastTs = 0;
-	float current;
-	std::string address;
-	const char *type;
-	CONTROLLERMODE controllerMode;
-
-	float lastValueIn = -1.f;
-	float lastValueIndicate = -1.f;
-	std::string lastValueOut = "-1";
+	static float clampValue(float value) { return value < 0.f ? 0.f : (value > 1.f ? 1.f : value); }
 };
 
-}  // namespace TheModularMind
\ No newline at end of file
+}  // namespace TheModularMind
@@ -20,12 +20,17 @@ class OscMessage {
 		address = oscMessage.address;
 		remoteHost = oscMessage.remoteHost;
 		remotePort = oscMessage.remotePort;
+		remoteAddress = oscMessage.remoteAddress;
+		receiveTime = oscMessage.receiveTime;
 
 		for (std::size_t i = 0; i < oscMessage.args.size(); ++i) {
 			switch (oscMessage.getArgType(i)) {
 			case osc::INT32_TYPE_TAG:
 				args.push_back(new OscArgInt32(oscMessage.getArgAsInt(i)));
 				break;
+			case osc::INT64_TYPE_TAG:
+				args.push_back(new OscArgInt64(oscMessage.getArgAsInt64(i)));
+				break;
 			case osc::FLOAT_TYPE_TAG:
 				args.push_back(new OscArgFloat(oscMessage.getArgAsFloat(i)));
 				break;
@@ -44,15 +49,18 @@ class OscMessage {
 		address = "";
 		remoteHost = "";
 		remotePort = 0;
+		remoteAddress = 0;
+		receiveTime = 0;
 		for (unsigned int i = 0; i < args.size(); ++i) {
 			delete args[i];
 		}
 		args.clear();
 	}
 
-	void setRemoteEndpoint(const std::string &host, int port) {
+	void setRemoteEndpoint(const std::string &host, int port, unsigned long address = 0) {
 		remoteHost = host;
 		remotePort = port;
+		remoteAddress = address;
 	}
 
 	osc::TypeTagValues getArgType(std::size_t index) const {
@@ -66,16 +74,23 @@ class OscMessage {
 
 	void setAddress(const std::string &address) { this->address = address; }
 	std::string getAddress() const { return address; }
+	/** Monotonic timestamp in nanoseconds when the packet was received, 0 if unknown */
+	void setReceiveTime(int64_t receiveTime) { this->receiveTime = receiveTime; }
+	int64_t getReceiveTime() const { return receiveTime; }
 	std::string getRemoteHost() const { return remoteHost; }
 	int getRemotePort() const { return remotePort; }
+	/** IPv4 address of the sender in host byte order like IpEndpointName::address, 0 if unknown */
+	unsigned long getRemoteAddress() const { return remoteAddress; }
 	std::size_t getNumArgs() const { return args.size(); }
 
 	std::int32_t getArgAsInt(std::size_t index) const { return ((OscArgInt32 *)args[index])->get(); }
+	std::int64_t getArgAsInt64(std::size_t index) const { return ((OscArgInt64 *)args[index])->get(); }
 	float getArgAsFloat(std::size_t index) const { return ((OscArgFloat *)args[index])->get(); }
 	std::string getArgAsString(std::size_t index) const { return ((OscArgString *)args[index])->get(); }
 
 	void addOscArg(OscArg* argument) { args.push_back(argument); }
 	void addIntArg(std::int32_t argument) { args.push_back(new OscArgInt32(argument)); }
+	void addInt64Arg(std::int64_t argument) { args.push_back(new OscArgInt64(argument)); }
 	void addFloatArg(float argument) { args.push_back(new OscArgFloat(argument)); }
 	void addStringArg(const std::string &argument) { args.push_back(new OscArgString(argument)); }
 
@@ -84,5 +99,7 @@ class OscMessage {
 	std::vector<OscArg *> args;
 	std::string remoteHost;
 	int remotePort;
+	unsigned long remoteAddress = 0;
+	int64_t receiveTime = 0;
 };
 }  // namespace TheModularMind
\ No newline at end of file
@@ -1,6 +1,10 @@
 #pragma once
 #include <functional>
+#include <mutex>
 #include <queue>
+#include "OscRecorder.hpp"
+#include "OscStats.hpp"
+#include "Trace.hpp"
 #include "oscpack/osc/OscPacketListener.h"
 
 namespace TheModularMind {
@@ -8,6 +12,8 @@ namespace TheModularMind {
 struct OscReceiver : public osc::OscPacketListener {
    public:
 	int port;
+	OscStats *stats = nullptr;
+	OscPacketRecorder recorder;
 
 	OscReceiver() {}
 
@@ -47,6 +53,7 @@ struct OscReceiver : public osc::OscPacketListener {
 	}
 
 	void listenerProcess() {
+		TRACE_THREAD("OSC listener");
 		while (listenSocket) {
 			try {
 				listenSocket->Run();
@@ -60,6 +67,7 @@ struct OscReceiver : public osc::OscPacketListener {
 
 	bool shift(OscMessage *message) {
 		if (!message) return false;
+		std::lock_guard<std::mutex> lock(queueMutex);
 		if (!queue.empty()) {
 			*message = queue.front();
 			queue.pop();
@@ -68,7 +76,37 @@ struct OscReceiver : public osc::OscPacketListener {
 		return false;
 	}
 
+	/** Feeds the packets of a recording into the queue as if they were received now */
+	bool startReplay(const std::string &path, bool realtime) {
+		return player.start(path, realtime, [this](const char *data, int size, const IpEndpointName &remoteEndpoint) { this->processPacket(data, size, remoteEndpoint); });
+	}
+	void stopReplay() { player.stop(); }
+	bool isReplaying() { return player.isPlaying(); }
+	uint64_t getReplayedPacketCount() { return player.getPacketCount(); }
+
+	virtual void ProcessPacket(const char *data, int size, const IpEndpointName &remoteEndpoint) override {
+		TRACE_ZONE("oscReceive");
+		if (recorder.isRecording()) recorder.record(data, size, remoteEndpoint);
+		processPacket(data, size, remoteEndpoint);
+	}
+
    protected:
+	void processPacket(const char *data, int size, const IpEndpointName &remoteEndpoint) {
+		// Serializes the listener and the replay thread
+		std::lock_guard<std::mutex> lock(packetMutex);
+		packetReceiveTime = LatencyHistogram::now();
+		if (stats) {
+			stats->packetsIn++;
+			stats->bytesIn += size;
+		}
+		try {
+			osc::OscPacketListener::ProcessPacket(data, size, remoteEndpoint);
+		} catch (osc::Exception &e) {
+			if (stats) stats->parseErrors++;
+			WARN("OscReceiver discarded malformed packet: %s", e.what());
+		}
+	}
+
 	/// process incoming OSC message and add it to the queue
 	virtual void ProcessMessage(const osc::ReceivedMessage &receivedMessage, const IpEndpointName &remoteEndpoint) override {
 		OscMessage msg;
@@ -76,7 +114,8 @@ struct OscReceiver : public osc::OscPacketListener {
 
 		remoteEndpoint.AddressAsString(endpointHost);
 		msg.setAddress(receivedMessage.AddressPattern());
-		msg.setRemoteEndpoint(endpointHost, remoteEndpoint.port);
+		msg.setRemoteEndpoint(endpointHost, remoteEndpoint.port, remoteEndpoint.address);
+		msg.setReceiveTime(packetReceiveTime);
 
 		for (auto arg = receivedMessage.ArgumentsBegin(); arg != receivedMessage.ArgumentsEnd(); ++arg) {
 			if (arg->IsInt32()) {
@@ -87,15 +126,26 @@ struct OscReceiver : public osc::OscPacketListener {
 				msg.addStringArg(arg->AsStringUnchecked());
 			} else {
 				FATAL("OscReceiver ProcessMessage(): argument in message %s is an unknown type %d", receivedMessage.AddressPattern(), arg->TypeTag());
+				if (stats) stats->parseErrors++;
 				break;
 			}
 		}
+
+		std::lock_guard<std::mutex> lock(queueMutex);
 		queue.push(msg);
+		if (stats) {
+			stats->messagesIn++;
+			stats->updateQueueDepth(queue.size());
+		}
 	}
 
    private:
 	std::unique_ptr<UdpListeningReceiveSocket, std::function<void(UdpListeningReceiveSocket *)>> listenSocket;
 	std::queue<OscMessage> queue;
+	std::mutex queueMutex;
+	std::mutex packetMutex;
+	OscPacketPlayer player;
+	int64_t packetReceiveTime = 0;
 	std::thread listenThread;
 };
 }  // namespace TheModularMind
\ No newline at end of file
@@ -0,0 +1,210 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "LatencyHistogram.hpp"
+#include "oscpack/ip/IpEndpointName.h"
+
+namespace TheModularMind {
+
+/**
+ * Binary log of received OSC packets: an 8 byte magic followed by one record per packet,
+ * 8 bytes receive time in ns since the start of the recording, 4 bytes IPv4 address,
+ * 2 bytes port, 4 bytes size and the raw packet, all in host byte order.
+ */
+static const char OSCLOG_MAGIC[8] = {'O', 'S', 'C', 'E', 'L', 'O', 'G', 1};
+static const int OSCLOG_RECORD_HEADER_SIZE = 18;
+
+/** Appends packets to a log file, the file is written by a background thread */
+struct OscPacketRecorder {
+	~OscPacketRecorder() { stop(); }
+
+	bool start(const std::string &path) {
+		stop();
+		file = std::fopen(path.c_str(), "wb");
+		if (!file) {
+			WARN("OscPacketRecorder couldn't open %s", path.c_str());
+			return false;
+		}
+		std::fwrite(OSCLOG_MAGIC, 1, sizeof(OSCLOG_MAGIC), file);
+		startTime = LatencyHistogram::now();
+		packets = 0;
+		recording = true;
+		writerThread = std::thread([this] { this->writerProcess(); });
+		return true;
+	}
+
+	void stop() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			recording = false;
+		}
+		condition.notify_one();
+		if (writerThread.joinable()) writerThread.join();
+		if (file) {
+			std::fclose(file);
+			file = nullptr;
+		}
+	}
+
+	bool isRecording() { return recording; }
+	uint64_t getPacketCount() { return packets; }
+
+	/** Called by the listener thread, only copies the packet into the pending buffer */
+	void record(const char *data, int size, const IpEndpointName &endpoint) {
+		uint64_t time = LatencyHistogram::now() - startTime;
+		uint32_t address = endpoint.address;
+		uint16_t port = endpoint.port;
+		uint32_t packetSize = size;
+
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!recording) return;
+		size_t offset = pending.size();
+		pending.resize(offset + OSCLOG_RECORD_HEADER_SIZE + size);
+		char *p = pending.data() + offset;
+		std::memcpy(p, &time, 8);
+		std::memcpy(p + 8, &address, 4);
+		std::memcpy(p + 12, &port, 2);
+		std::memcpy(p + 14, &packetSize, 4);
+		std::memcpy(p + OSCLOG_RECORD_HEADER_SIZE, data, size);
+		packets++;
+		condition.notify_one();
+	}
+
+   private:
+	FILE *file = nullptr;
+	std::thread writerThread;
+	std::mutex mutex;
+	std::condition_variable condition;
+	std::vector<char> pending;
+	std::vector<char> writing;
+	std::atomic<bool> recording{false};
+	std::atomic<uint64_t> packets{0};
+	int64_t startTime = 0;
+
+	void writerProcess() {
+		while (true) {
+			bool stopping;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				condition.wait(lock, [this] { return !pending.empty() || !recording; });
+				std::swap(pending, writing);
+				stopping = !recording;
+			}
+			if (!writing.empty()) {
+				std::fwrite(writing.data(), 1, writing.size(), file);
+				std::fflush(file);
+				writing.clear();
+			}
+			if (stopping) break;
+		}
+	}
+};
+
+/** Sequential reader of a log written by OscPacketRecorder */
+struct OscPacketLogReader {
+	~OscPacketLogReader() { close(); }
+
+	bool open(const std::string &path) {
+		close();
+		file = std::fopen(path.c_str(), "rb");
+		if (!file) {
+			WARN("OscPacketLogReader couldn't open %s", path.c_str());
+			return false;
+		}
+		char magic[sizeof(OSCLOG_MAGIC)];
+		if (std::fread(magic, 1, sizeof(magic), file) != sizeof(magic) || std::memcmp(magic, OSCLOG_MAGIC, sizeof(magic)) != 0) {
+			WARN("OscPacketLogReader: %s is no OSC recording", path.c_str());
+			close();
+			return false;
+		}
+		return true;
+	}
+
+	void close() {
+		if (file) {
+			std::fclose(file);
+			file = nullptr;
+		}
+	}
+
+	/** Reads the next packet, time is in ns since the start of the recording */
+	bool next(uint64_t &time, IpEndpointName &endpoint, std::vector<char> &data) {
+		char header[OSCLOG_RECORD_HEADER_SIZE];
+		if (!file || std::fread(header, 1, sizeof(header), file) != sizeof(header)) return false;
+		uint32_t address;
+		uint16_t port;
+		uint32_t size;
+		std::memcpy(&time, header, 8);
+		std::memcpy(&address, header + 8, 4);
+		std::memcpy(&port, header + 12, 2);
+		std::memcpy(&size, header + 14, 4);
+		data.resize(size);
+		if (std::fread(data.data(), 1, size, file) != size) return false;
+		endpoint = IpEndpointName(address, port);
+		return true;
+	}
+
+   private:
+	FILE *file = nullptr;
+};
+
+/** Replays a log written by OscPacketRecorder at the original timing or as fast as possible */
+struct OscPacketPlayer {
+	typedef std::function<void(const char *, int, const IpEndpointName &)> PacketCallback;
+
+	~OscPacketPlayer() { stop(); }
+
+	bool start(const std::string &path, bool realtime, PacketCallback callback) {
+		stop();
+		if (!reader.open(path)) return false;
+		playing = true;
+		playerThread = std::thread([=] { this->playerProcess(realtime, callback); });
+		return true;
+	}
+
+	void stop() {
+		playing = false;
+		if (playerThread.joinable()) playerThread.join();
+	}
+
+	bool isPlaying() { return playing; }
+	uint64_t getPacketCount() { return packets; }
+
+   private:
+	OscPacketLogReader reader;
+	std::thread playerThread;
+	std::atomic<bool> playing{false};
+	std::atomic<uint64_t> packets{0};
+
+	void playerProcess(bool realtime, PacketCallback callback) {
+		auto startTime = std::chrono::steady_clock::now();
+		std::vector<char> data;
+		uint64_t time;
+		IpEndpointName endpoint;
+		packets = 0;
+
+		while (playing && reader.next(time, endpoint, data)) {
+			if (realtime) {
+				auto packetTime = startTime + std::chrono::nanoseconds(time);
+				// Sleep in short steps to stay responsive to stop()
+				while (playing && std::chrono::steady_clock::now() < packetTime) {
+					std::this_thread::sleep_until(std::min(packetTime, std::chrono::steady_clock::now() + std::chrono::milliseconds(50)));
+				}
+				if (!playing) break;
+			}
+			callback(data.data(), data.size(), endpoint);
+			packets++;
+		}
+		reader.close();
+		playing = false;
+	}
+};
+
+}  // namespace TheModularMind
@@ -1,14 +1,148 @@
 #pragma once
+#include <chrono>
+#include <functional>
+#include <mutex>
 #include "OscBundle.hpp"
+#include "OscStats.hpp"
+#include "TokenBucket.hpp"
+#include "Trace.hpp"
 #include "oscpack/ip/UdpSocket.h"
 #include "oscpack/osc/OscOutboundPacketStream.h"
 
 namespace TheModularMind {
 
+enum ECHOMODE { ECHOMODE_OFF = 0, ECHOMODE_SUPPRESS = 1, ECHOMODE_DELAY = 2 };
+
+/** Remote endpoint which changed a slot most recently */
+struct FeedbackOrigin {
+	/** IPv4 address like IpEndpointName::address, compared with the resolved destinations */
+	unsigned long address = 0;
+	int port = 0;
+	double time = -1.0;
+};
+
+/** Slots first..first+count-1 subscribed or unsubscribed by a client, not limited to the slots which exist */
+struct SubscriptionRange {
+	int first = 0;
+	int count = 0;
+	bool subscribe = true;
+
+	bool contains(int slot) const { return slot >= first && (int64_t)slot < (int64_t)first + count; }
+	bool covers(const SubscriptionRange &range) const { return range.first >= first && (int64_t)range.first + range.count <= (int64_t)first + count; }
+};
+
+struct OscDestination {
+	static const int MAX_SUBSCRIPTIONS = 32;
+
+	std::string host;
+	int port = 0;
+	bool enabled = true;
+	/** The destination configured on the panel, managed by start() */
+	bool primary = false;
+	/** Registered automatically from incoming messages, not saved */
+	bool autoRegistered = false;
+	/** Stable id, indices change when destinations are removed */
+	uint32_t id = 0;
+	double lastSeen = 0.0;
+	/** Port registered clients send from, might differ from the port feedback is sent to */
+	int sourcePort = -1;
+	IpEndpointName endpoint;
+	/** If the client subscribed to slot ranges it only receives feedback for these slots, later ranges take precedence */
+	SubscriptionRange subscriptions[MAX_SUBSCRIPTIONS];
+	int subscriptionCount = 0;
+
+	uint32_t packetsSent = 0;
+	uint64_t bytesSent = 0;
+	/** Feedback which was delayed by the rate limit and later replaced by a newer value */
+	uint32_t packetsCoalesced = 0;
+	/** Feedback withheld because this destination sent the value itself */
+	uint32_t packetsEchoSuppressed = 0;
+
+	TokenBucket packetBucket;
+	TokenBucket byteBucket;
+	/** Slots with feedback waiting for tokens, 0 = none, 1 = value, 2 = value and info */
+	std::vector<uint8_t> pendingSlots;
+	int pendingCount = 0;
+
+	bool isAvailable(double now) {
+		packetBucket.refill(now);
+		byteBucket.refill(now);
+		return packetBucket.isAvailable() && byteBucket.isAvailable();
+	}
+
+	void consume(std::size_t size) {
+		packetBucket.consume(1.f);
+		byteBucket.consume(float(size));
+	}
+
+	bool hasSubscriptions() const { return subscriptionCount > 0; }
+
+	bool isSubscribed(int slot) const {
+		if (subscriptionCount == 0) return true;
+		for (int i = subscriptionCount - 1; i >= 0; i--) {
+			if (subscriptions[i].contains(slot)) return subscriptions[i].subscribe;
+		}
+		return false;
+	}
+
+	/** Number of subscribed slots below slotCount */
+	int getSubscribedCount(int slotCount) const {
+		int count = 0;
+		for (int slot = 0; slot < slotCount; slot++) {
+			if (isSubscribed(slot)) count++;
+		}
+		return count;
+	}
+
+	/** Ranges covered by the new one are dropped, if there are still too many the oldest one is dropped */
+	void addSubscription(const SubscriptionRange &range) {
+		int n = 0;
+		for (int i = 0; i < subscriptionCount; i++) {
+			if (!range.covers(subscriptions[i])) subscriptions[n++] = subscriptions[i];
+		}
+		subscriptionCount = n;
+		if (subscriptionCount == MAX_SUBSCRIPTIONS) {
+			std::copy(subscriptions + 1, subscriptions + subscriptionCount, subscriptions);
+			subscriptionCount--;
+		}
+		subscriptions[subscriptionCount++] = range;
+	}
+
+	void setPending(int slot, bool fullFeedback) {
+		if (slot >= (int)pendingSlots.size()) pendingSlots.resize(slot + 1, 0);
+		if (pendingSlots[slot] == 0) {
+			pendingCount++;
+		} else {
+			packetsCoalesced++;
+		}
+		pendingSlots[slot] = std::max(pendingSlots[slot], uint8_t(fullFeedback ? 2 : 1));
+	}
+
+	void clearPending(int slot) {
+		if (slot >= (int)pendingSlots.size() || pendingSlots[slot] == 0) return;
+		pendingSlots[slot] = 0;
+		pendingCount--;
+	}
+
+	/** After the value of a slot has been sent, pending info is still sent later on */
+	void clearPendingValue(int slot) {
+		if (slot < (int)pendingSlots.size() && pendingSlots[slot] == 2) return;
+		clearPending(slot);
+	}
+
+	bool isResolved() const { return endpoint.address != 0 && endpoint.address != IpEndpointName::ANY_ADDRESS; }
+	std::string getName() const { return host + ":" + std::to_string(port); }
+};
+
 class OscSender {
    public:
+	static const int OUTPUT_BUFFER_SIZE = 327680;
+	/** Returned instead of a destination id while the destinations are locked */
+	static const uint32_t DESTINATIONS_BUSY = UINT32_MAX;
+
 	std::string host;
 	int port = 0;
+	OscStats *stats = nullptr;
 
 	OscSender() {}
 
@@ -21,19 +155,20 @@ class OscSender {
 			host = "localhost";
 		}
 
-		UdpTransmitSocket *socket = nullptr;
+		UdpSocket *socket = nullptr;
 		try {
 			IpEndpointName name = IpEndpointName(host.c_str(), port);
 			if (!name.address) {
 				FATAL("Bad hostname: %s", host.c_str());
 				return false;
 			}
-			socket = new UdpTransmitSocket(name);
+			socket = new UdpSocket();
 			sendSocket.reset(socket);
+			setPrimaryDestination(host, port, name);
 
 		} catch (std::exception &e) {
 			FATAL("OscSender couldn't start with %s:%i because of: %s", host.c_str(), port, e.what());
-			if (socket != nullptr) {
+			if (socket != nullptr && sendSocket.get() != socket) {
 				delete socket;
 				socket = nullptr;
 			}
@@ -45,17 +180,321 @@ class OscSender {
 
 	void stop() { sendSocket.reset(); }
 
+	/** Adds an additional feedback destination, returns false if the host could not be resolved */
+	bool addDestination(const std::string &host, int port, bool enabled = true) {
+		OscDestination destination;
+		destination.host = host;
+		destination.port = port;
+		destination.enabled = enabled;
+		destination.endpoint = IpEndpointName(host.c_str(), port);
+
+		std::lock_guard<std::mutex> lock(destinationMutex);
+		destination.id = nextDestinationId++;
+		destination.packetBucket.setRate(packetRateLimit);
+		destination.byteBucket.setRate(byteRateLimit);
+		destinations.push_back(destination);
+		return destination.isResolved();
+	}
+
+	/**
+	 * Registers the endpoint of a remote client as destination or refreshes its idle timer.
+	 * Returns the id of a newly registered client or 0 if it was already known. Called by the
+	 * engine thread, which only tries to lock the destinations: while the UI holds them the
+	 * client is touched again with its next message.
+	 */
+	uint32_t touchClient(const IpEndpointName &endpoint, int sourcePort, double now) {
+		std::unique_lock<std::mutex> lock(destinationMutex, std::try_to_lock);
+		if (!lock.owns_lock()) return 0;
+		for (OscDestination &destination : destinations) {
+			if (destination.port == endpoint.port && destination.endpoint.address == endpoint.address) {
+				destination.lastSeen = now;
+				if (destination.autoRegistered) destination.sourcePort = sourcePort;
+				return 0;
+			}
+		}
+
+		OscDestination destination;
+		destination.port = endpoint.port;
+		destination.sourcePort = sourcePort;
+		destination.autoRegistered = true;
+		destination.lastSeen = now;
+		destination.endpoint = endpoint;
+		if (!destination.isResolved()) return 0;
+		destination.host = getHost(endpoint);
+		destination.id = nextDestinationId++;
+		destination.packetBucket.setRate(packetRateLimit);
+		destination.byteBucket.setRate(byteRateLimit);
+		destinations.push_back(destination);
+		return destination.id;
+	}
+
+	/**
+	 * Subscribes a client to feedback of the slots first..first+count-1, or unsubscribes it.
+	 * Unknown clients are registered like in touchClient(). A negative count removes all
+	 * subscriptions, so the client receives feedback of all slots again, including slots added later.
+	 * endpoint is the address of the client with the port feedback is sent to. Returns the id of
+	 * the client's destination, 0 if the address isn't valid or DESTINATIONS_BUSY if the UI holds
+	 * the destinations right now, the engine thread doesn't wait for them.
+	 */
+	uint32_t setSubscription(const IpEndpointName &endpoint, int sourcePort, int first, int count, bool subscribe, double now) {
+		std::unique_lock<std::mutex> lock(destinationMutex, std::try_to_lock);
+		if (!lock.owns_lock()) return DESTINATIONS_BUSY;
+		OscDestination *client = nullptr;
+		for (OscDestination &destination : destinations) {
+			if (destination.endpoint.address == endpoint.address && (destination.port == endpoint.port || destination.sourcePort == sourcePort)) {
+				client = &destination;
+				break;
+			}
+		}
+		if (!client) {
+			OscDestination destination;
+			destination.port = endpoint.port;
+			destination.sourcePort = sourcePort;
+			destination.autoRegistered = true;
+			destination.endpoint = endpoint;
+			if (!destination.isResolved()) return 0;
+			destination.host = getHost(endpoint);
+			destination.id = nextDestinationId++;
+			destination.packetBucket.setRate(packetRateLimit);
+			destination.byteBucket.setRate(byteRateLimit);
+			destinations.push_back(destination);
+			client = &destinations.back();
+		}
+		client->lastSeen = now;
+
+		if (count < 0) {
+			client->subscriptionCount = 0;
+			return client->id;
+		}
+		if (first < 0 || count <= 0) return client->id;
+		SubscriptionRange range;
+		range.first = first;
+		range.count = count;
+		range.subscribe = subscribe;
+		client->addSubscription(range);
+		return client->id;
+	}
+
+	/** Removes automatically registered clients which have been idle for longer than timeout seconds */
+	void expireClients(double now, double timeout) {
+		std::lock_guard<std::mutex> lock(destinationMutex);
+		destinations.erase(std::remove_if(destinations.begin(), destinations.end(), [=](const OscDestination &d) { return d.autoRegistered && now - d.lastSeen > timeout; }), destinations.end());
+		updatePendingDestinations();
+	}
+
+	void removeAutoRegisteredClients() {
+		std::lock_guard<std::mutex> lock(destinationMutex);
+		destinations.erase(std::remove_if(destinations.begin(), destinations.end(), [](const OscDestination &d) { return d.autoRegistered; }), destinations.end());
+		updatePendingDestinations();
+	}
+
+	void removeDestination(size_t index) {
+		std::lock_guard<std::mutex> lock(destinationMutex);
+		if (index >= destinations.size() || destinations[index].primary) return;
+		destinations.erase(destinations.begin() + index);
+		updatePendingDestinations();
+	}
+
+	/** Removes all additional destinations, keeps the primary one and registered clients */
+	void clearDestinations() {
+		std::lock_guard<std::mutex> lock(destinationMutex);
+		destinations.erase(std::remove_if(destinations.begin(), destinations.end(), [](const OscDestination &d) { return !d.primary && !d.autoRegistered; }), destinations.end());
+		updatePendingDestinations();
+	}
+
+	void setDestinationEnabled(size_t index, bool enabled) {
+		std::lock_guard<std::mutex> lock(destinationMutex);
+		if (index >= destinations.size()) return;
+		destinations[index].enabled = enabled;
+	}
+
+	bool isDestinationEnabled(size_t index) {
+		std::lock_guard<std::mutex> lock(destinationMutex);
+		return index < destinations.size() && destinations[index].enabled;
+	}
+
+	void resetDestinationCounters() {
+		std::lock_guard<std::mutex> lock(destinationMutex);
+		for (OscDestination &destination : destinations) {
+			destination.packetsSent = 0;
+			destination.bytesSent = 0;
+			destination.packetsCoalesced = 0;
+			destination.packetsEchoSuppressed = 0;
+		}
+	}
+
+	/** Limits the feedback of every destination to packetRate packets and byteRate bytes per second, 0 = unlimited */
+	void setRateLimit(float packetRate, float byteRate) {
+		std::lock_guard<std::mutex> lock(destinationMutex);
+		packetRateLimit = packetRate;
+		byteRateLimit = byteRate;
+		for (OscDestination &destination : destinations) {
+			destination.packetBucket.setRate(packetRate);
+			destination.byteBucket.setRate(byteRate);
+		}
+	}
+
+	/** Returns a copy of the destination list, used by the UI and for saving */
+	std::vector<OscDestination> getDestinations() {
+		std::lock_guard<std::mutex> lock(destinationMutex);
+		return destinations;
+	}
+
 	void sendBundle(const OscBundle &bundle) {
 		if (!sendSocket) {
 			FATAL("OscSender trying to send with empty socket");
 			return;
 		}
 
-		static const int OUTPUT_BUFFER_SIZE = 327680;
-		char buffer[OUTPUT_BUFFER_SIZE];
 		osc::OutboundPacketStream outputStream(buffer, OUTPUT_BUFFER_SIZE);
 		appendBundle(bundle, outputStream);
-		sendSocket->Send(outputStream.Data(), outputStream.Size());
+		sendPacket(outputStream.Data(), outputStream.Size());
+	}
+
+	/**
+	 * Configures how feedback is handled for the client which changed a slot itself: During
+	 * holdTime seconds it is either not sent at all or delayed until the hold time has passed.
+	 * With matchPort the origin must match host and port of the destination, otherwise the host.
+	 */
+	void setEchoSuppression(ECHOMODE mode, float holdTime, bool matchPort) {
+		std::lock_guard<std::mutex> lock(destinationMutex);
+		echoMode = mode;
+		echoHoldTime = holdTime;
+		echoMatchPort = matchPort;
+	}
+
+	void setSlotOrigin(int slot, unsigned long address, int port) {
+		std::lock_guard<std::mutex> lock(destinationMutex);
+		if (slot >= (int)slotOrigins.size()) slotOrigins.resize(slot + 1);
+		slotOrigins[slot].address = address;
+		slotOrigins[slot].port = port;
+		slotOrigins[slot].time = getTime();
+	}
+
+	/**
+	 * Sends the feedback bundle of a mapping slot to all destinations with available tokens.
+	 * Destinations over their rate limit remember the slot and receive its latest state
+	 * later on from flushPendingFeedback().
+	 */
+	void sendFeedback(int slot, bool fullFeedback, const OscBundle &bundle) {
+		if (!sendSocket) {
+			FATAL("OscSender trying to send with empty socket");
+			return;
+		}
+
+		osc::OutboundPacketStream outputStream(buffer, OUTPUT_BUFFER_SIZE);
+		appendBundle(bundle, outputStream);
+
+		double now = getTime();
+		std::lock_guard<std::mutex> lock(destinationMutex);
+		sendEndpoints.clear();
+		sendIndices.clear();
+		for (size_t i = 0; i < destinations.size(); i++) {
+			OscDestination &destination = destinations[i];
+			if (!destination.enabled || !destination.isResolved() || !destination.isSubscribed(slot)) continue;
+			if (isEcho(destination, slot, now)) {
+				if (echoMode == ECHOMODE_DELAY) destination.setPending(slot, fullFeedback);
+				destination.packetsEchoSuppressed++;
+				continue;
+			}
+			if (!destination.isAvailable(now)) {
+				destination.setPending(slot, fullFeedback);
+				continue;
+			}
+			if (fullFeedback) {
+				destination.clearPending(slot);
+			} else {
+				destination.clearPendingValue(slot);
+			}
+			destination.consume(outputStream.Size());
+			sendEndpoints.push_back(destination.endpoint);
+			sendIndices.push_back(i);
+		}
+		sendPacketToIndices(outputStream.Data(), outputStream.Size());
+	}
+
+	/** Queues feedback of a slot for a single destination, e.g. the initial snapshot for a new client */
+	void queueFeedback(uint32_t destinationId, int slot, bool fullFeedback) {
+		std::lock_guard<std::mutex> lock(destinationMutex);
+		for (OscDestination &destination : destinations) {
+			if (destination.id != destinationId) continue;
+			if (destination.isSubscribed(slot)) destination.setPending(slot, fullFeedback);
+			updatePendingDestinations();
+			return;
+		}
+	}
+
+	bool hasPendingFeedback() { return pendingDestinations > 0; }
+
+	/**
+	 * Sends delayed feedback to destinations whose tokens have been refilled. The bundle of a
+	 * slot is built when it is actually sent, so only the latest value is transmitted.
+	 */
+	void flushPendingFeedback(std::function<bool(int, bool, OscBundle &)> getBundle) {
+		if (!sendSocket) return;
+		double now = getTime();
+
+		std::lock_guard<std::mutex> lock(destinationMutex);
+		size_t slotCount = 0;
+		for (OscDestination &destination : destinations) {
+			slotCount = std::max(slotCount, destination.pendingSlots.size());
+			destination.isAvailable(now);
+		}
+
+		for (size_t n = 0; n < slotCount; n++) {
+			// Rotate the starting slot so busy low slots can't starve the others
+			int slot = (flushOffset + n) % slotCount;
+			bool fullFeedback = false;
+			sendIndices.clear();
+			for (size_t i = 0; i < destinations.size(); i++) {
+				OscDestination &destination = destinations[i];
+				if (slot >= (int)destination.pendingSlots.size() || destination.pendingSlots[slot] == 0) continue;
+				if (!destination.isSubscribed(slot)) {
+					destination.clearPending(slot);
+					continue;
+				}
+				if (!destination.enabled || !destination.packetBucket.isAvailable() || !destination.byteBucket.isAvailable()) continue;
+				if (isEcho(destination, slot, now)) continue;
+				fullFeedback |= destination.pendingSlots[slot] == 2;
+				sendIndices.push_back(i);
+			}
+			if (sendIndices.empty()) continue;
+
+			OscBundle bundle;
+			bool valid = getBundle(slot, fullFeedback, bundle);
+			sendEndpoints.clear();
+			osc::OutboundPacketStream outputStream(buffer, OUTPUT_BUFFER_SIZE);
+			if (valid) appendBundle(bundle, outputStream);
+			for (size_t i : sendIndices) {
+				destinations[i].clearPending(slot);
+				if (!valid) continue;
+				destinations[i].consume(outputStream.Size());
+				sendEndpoints.push_back(destinations[i].endpoint);
+			}
+			if (valid) sendPacketToIndices(outputStream.Data(), outputStream.Size());
+		}
+		flushOffset = slotCount > 0 ? (flushOffset + 1) % slotCount : 0;
+		updatePendingDestinations();
+	}
+
+	/** Sends a message to an arbitrary endpoint, e.g. the reply to a query */
+	void sendMessageTo(const OscMessage &message, const IpEndpointName &endpoint) {
+		if (!sendSocket) return;
+		if (!endpoint.address || endpoint.address == IpEndpointName::ANY_ADDRESS) return;
+
+		osc::OutboundPacketStream outputStream(buffer, OUTPUT_BUFFER_SIZE);
+		appendMessage(message, outputStream);
+		sendSocket->SendTo(endpoint, outputStream.Data(), outputStream.Size());
+		if (stats) {
+			stats->packetsOut++;
+			stats->bytesOut += outputStream.Size();
+		}
+	}
+
+	/** Sends a packet encoded by the caller to all destinations, e.g. with a stream reused on the engine thread */
+	void sendEncodedPacket(const osc::OutboundPacketStream &packet) {
+		if (!sendSocket || packet.Size() == 0) return;
+		sendPacket(packet.Data(), packet.Size());
 	}
 
 	void sendMessage(const OscMessage &message) {
@@ -64,15 +503,104 @@ class OscSender {
 			return;
 		}
 
-		static const int OUTPUT_BUFFER_SIZE = 327680;
-		char buffer[OUTPUT_BUFFER_SIZE];
 		osc::OutboundPacketStream outputStream(buffer, OUTPUT_BUFFER_SIZE);
 		appendMessage(message, outputStream);
-		sendSocket->Send(outputStream.Data(), outputStream.Size());
+		sendPacket(outputStream.Data(), outputStream.Size());
 	}
 
    private:
-	std::unique_ptr<UdpTransmitSocket> sendSocket;
+	std::unique_ptr<UdpSocket> sendSocket;
+	std::vector<OscDestination> destinations;
+	std::mutex destinationMutex;
+
+	/** Encode buffer, every packet is encoded once and then sent to all destinations */
+	char buffer[OUTPUT_BUFFER_SIZE];
+	std::vector<IpEndpointName> sendEndpoints;
+	std::vector<size_t> sendIndices;
+	/** Per endpoint of sendEndpoints whether the packet was sent */
+	std::vector<unsigned char> sendResults;
+	uint32_t nextDestinationId = 1;
+	float packetRateLimit = 0.f;
+	float byteRateLimit = 0.f;
+	int pendingDestinations = 0;
+	size_t flushOffset = 0;
+
+	ECHOMODE echoMode = ECHOMODE_OFF;
+	float echoHoldTime = 0.f;
+	bool echoMatchPort = false;
+	std::vector<FeedbackOrigin> slotOrigins;
+
+	/** Checks if the destination changed the slot itself within the hold time, destinationMutex must be held */
+	bool isEcho(const OscDestination &destination, int slot, double now) {
+		if (echoMode == ECHOMODE_OFF || slot >= (int)slotOrigins.size()) return false;
+		const FeedbackOrigin &origin = slotOrigins[slot];
+		if (origin.time < 0.0 || now - origin.time > echoHoldTime) return false;
+		// Host names like "localhost" are resolved, the origin is always an address
+		if (origin.address == 0 || destination.endpoint.address != origin.address) return false;
+		return !echoMatchPort || destination.port == origin.port || destination.sourcePort == origin.port;
+	}
+
+	static double getTime() { return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count(); }
+
+	/** Address of an endpoint as shown for registered clients, no lookup */
+	static std::string getHost(const IpEndpointName &endpoint) {
+		char host[IpEndpointName::ADDRESS_STRING_LENGTH];
+		endpoint.AddressAsString(host);
+		return host;
+	}
+
+	void updatePendingDestinations() {
+		pendingDestinations = 0;
+		for (OscDestination &destination : destinations) {
+			if (destination.pendingCount > 0) pendingDestinations++;
+		}
+	}
+
+	void setPrimaryDestination(const std::string &host, int port, const IpEndpointName &endpoint) {
+		std::lock_guard<std::mutex> lock(destinationMutex);
+		if (destinations.empty() || !destinations[0].primary) {
+			destinations.insert(destinations.begin(), OscDestination());
+			destinations[0].primary = true;
+			destinations[0].id = nextDestinationId++;
+			destinations[0].packetBucket.setRate(packetRateLimit);
+			destinations[0].byteBucket.setRate(byteRateLimit);
+		}
+		destinations[0].host = host;
+		destinations[0].port = port;
+		destinations[0].endpoint = endpoint;
+	}
+
+	void sendPacket(const char *data, std::size_t size) {
+		std::lock_guard<std::mutex> lock(destinationMutex);
+		sendEndpoints.clear();
+		sendIndices.clear();
+		for (size_t i = 0; i < destinations.size(); i++) {
+			if (!destinations[i].enabled || !destinations[i].isResolved()) continue;
+			sendEndpoints.push_back(destinations[i].endpoint);
+			sendIndices.push_back(i);
+		}
+		sendPacketToIndices(data, size);
+	}
+
+	/** Sends to sendEndpoints and updates the counters of the matching sendIndices, destinationMutex must be held */
+	void sendPacketToIndices(const char *data, std::size_t size) {
+		TRACE_ZONE("oscSend");
+		// Also when nothing is sent as all destinations might have just been deferred
+		updatePendingDestinations();
+		if (sendEndpoints.empty()) return;
+
+		sendResults.resize(sendEndpoints.size());
+		std::size_t sent = sendSocket->SendToMany(sendEndpoints.data(), sendEndpoints.size(), data, size, sendResults.data());
+		for (std::size_t i = 0; i < sendEndpoints.size(); i++) {
+			if (!sendResults[i]) continue;
+			destinations[sendIndices[i]].packetsSent++;
+			destinations[sendIndices[i]].bytesSent += size;
+		}
+		if (stats) {
+			stats->packetsOut += sent;
+			stats->bytesOut += sent * size;
+		}
+	}
 
 	void appendBundle(const OscBundle &bundle, osc::OutboundPacketStream &outputStream) {
 		outputStream << osc::BeginBundleImmediate;
@@ -92,6 +620,9 @@ class OscSender {
 			case osc::INT32_TYPE_TAG:
 				outputStream << message.getArgAsInt(i);
 				break;
+			case osc::INT64_TYPE_TAG:
+				outputStream << (osc::int64)message.getArgAsInt64(i);
+				break;
 			case osc::FLOAT_TYPE_TAG:
 				outputStream << message.getArgAsFloat(i);
 				break;
@@ -106,4 +637,4 @@ class OscSender {
 		outputStream << osc::EndMessage;
 	}
 };
-}  // namespace TheModularMind
\ No newline at end of file
+}  // namespace TheModularMind
@@ -0,0 +1,61 @@
+#pragma once
+#include <atomic>
+#include "LatencyHistogram.hpp"
+
+namespace TheModularMind {
+
+/**
+ * Runtime counters of the OSC receiver, sender and the module's processing. Written by the
+ * listener and the engine thread, read by the UI and /oscelot/stats queries.
+ */
+struct OscStats {
+	std::atomic<uint64_t> packetsIn{0};
+	std::atomic<uint64_t> bytesIn{0};
+	std::atomic<uint64_t> messagesIn{0};
+	std::atomic<uint64_t> parseErrors{0};
+	/** Messages which didn't match any mapping slot or command */
+	std::atomic<uint64_t> unknownAddresses{0};
+	/** Well-formed messages discarded because of missing or invalid arguments */
+	std::atomic<uint64_t> invalidMessages{0};
+	std::atomic<uint64_t> packetsOut{0};
+	std::atomic<uint64_t> bytesOut{0};
+	std::atomic<uint32_t> queueHighWater{0};
+
+	/** Feedback packets sent during the last second */
+	std::atomic<float> feedbackRate{0.f};
+	/** Processing time of the last, the longest and the average tick in microseconds */
+	std::atomic<float> tickTime{0.f};
+	std::atomic<float> tickTimeMax{0.f};
+	std::atomic<float> tickTimeAvg{0.f};
+	/** Time from receiving a message until the mapped parameter is written */
+	LatencyHistogram latency;
+
+	void updateQueueDepth(uint32_t depth) {
+		if (depth > queueHighWater.load()) queueHighWater.store(depth);
+	}
+
+	void addTickTime(float time) {
+		tickTime.store(time);
+		if (time > tickTimeMax.load()) tickTimeMax.store(time);
+		tickTimeAvg.store(tickTimeAvg.load() * 0.99f + time * 0.01f);
+	}
+
+	void reset() {
+		packetsIn = 0;
+		bytesIn = 0;
+		messagesIn = 0;
+		parseErrors = 0;
+		unknownAddresses = 0;
+		invalidMessages = 0;
+		packetsOut = 0;
+		bytesOut = 0;
+		queueHighWater = 0;
+		feedbackRate = 0.f;
+		tickTime = 0.f;
+		tickTimeMax = 0.f;
+		tickTimeAvg = 0.f;
+		latency.reset();
+	}
+};
+
+}  // namespace TheModularMind
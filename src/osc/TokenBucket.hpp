@@ -0,0 +1,38 @@
+#pragma once
+#include <algorithm>
+
+namespace TheModularMind {
+
+/**
+ * Token bucket rate limiter. A rate of 0 disables limiting. The bucket may go into debt
+ * so packets larger than the burst size still pass once the bucket has been refilled.
+ */
+struct TokenBucket {
+	/** Tokens per second */
+	float rate = 0.f;
+	/** Capacity in seconds of rate */
+	float burstTime = 0.1f;
+	float tokens = 0.f;
+	double lastRefill = 0.0;
+
+	void setRate(float rate) {
+		this->rate = rate;
+		tokens = getBurst();
+	}
+
+	float getBurst() { return std::max(rate * burstTime, 1.f); }
+
+	void refill(double now) {
+		if (rate <= 0.f) return;
+		tokens = std::min(tokens + float(now - lastRefill) * rate, getBurst());
+		lastRefill = now;
+	}
+
+	bool isAvailable() { return rate <= 0.f || tokens > 0.f; }
+
+	void consume(float n) {
+		if (rate > 0.f) tokens -= n;
+	}
+};
+
+}  // namespace TheModularMind
@@ -0,0 +1,132 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * Scoped trace zones, compiled in with OSCELOT_TRACE only (make TRACE=1). Every thread
+ * records into its own lock-free ring buffer, allocated on its first zone or, for threads which
+ * must not allocate, created beforehand and bound with TRACE_BIND(). The buffers can be written
+ * as Chrome trace JSON (chrome://tracing, Perfetto) from the context menu.
+ */
+#ifdef OSCELOT_TRACE
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_ZONE(name) TheModularMind::TraceZone TRACE_CONCAT(traceZone, __LINE__)(name)
+#define TRACE_THREAD(threadName) TheModularMind::TraceBuffer::get()->name = threadName
+#define TRACE_BIND(buffer) TheModularMind::TraceBuffer::current() = buffer
+#else
+#define TRACE_ZONE(name) ((void)0)
+#define TRACE_THREAD(threadName) ((void)0)
+#define TRACE_BIND(buffer) ((void)0)
+#endif
+
+namespace TheModularMind {
+
+struct TraceEvent {
+	const char *name;
+	int64_t start;
+	int64_t duration;
+};
+
+/** Ring buffer of the events of one thread, written by its thread only */
+struct TraceBuffer {
+	static const uint64_t CAPACITY = 1 << 16;
+
+	const char *name = "thread";
+	int tid;
+	TraceEvent events[CAPACITY];
+	std::atomic<uint64_t> head{0};
+
+	void push(const char *name, int64_t start, int64_t duration) {
+		uint64_t h = head.load(std::memory_order_relaxed);
+		TraceEvent &event = events[h % CAPACITY];
+		event.name = name;
+		event.start = start;
+		event.duration = duration;
+		head.store(h + 1, std::memory_order_release);
+	}
+
+	/** Copies the events still present in the ring, events overwritten while copying are dropped */
+	void copy(std::vector<TraceEvent> &out) {
+		uint64_t end = head.load(std::memory_order_acquire);
+		uint64_t begin = end > CAPACITY ? end - CAPACITY : 0;
+		size_t offset = out.size();
+		for (uint64_t i = begin; i < end; i++) out.push_back(events[i % CAPACITY]);
+		uint64_t after = head.load(std::memory_order_acquire);
+		uint64_t valid = after > CAPACITY ? after - CAPACITY : 0;
+		if (valid > begin) out.erase(out.begin() + offset, out.begin() + offset + (std::min(valid, end) - begin));
+	}
+
+	static std::mutex &getMutex() {
+		static std::mutex mutex;
+		return mutex;
+	}
+
+	/** Buffers of all threads which ever recorded, never freed so they can be written after a thread ended */
+	static std::vector<TraceBuffer *> &getBuffers() {
+		static std::vector<TraceBuffer *> buffers;
+		return buffers;
+	}
+
+	/** Allocates and registers a buffer, for threads which must not allocate it on their first zone */
+	static TraceBuffer *create(const char *name) {
+		TraceBuffer *buffer = new TraceBuffer;
+		buffer->name = name;
+		std::lock_guard<std::mutex> lock(getMutex());
+		buffer->tid = getBuffers().size() + 1;
+		getBuffers().push_back(buffer);
+		return buffer;
+	}
+
+	/** Buffer the zones of the calling thread record into, set with TRACE_BIND() */
+	static TraceBuffer *&current() {
+		static thread_local TraceBuffer *buffer = nullptr;
+		return buffer;
+	}
+
+	static TraceBuffer *get() {
+		TraceBuffer *&buffer = current();
+		if (!buffer) buffer = create("thread");
+		return buffer;
+	}
+
+	static int64_t now() { return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count(); }
+
+	/** Writes all buffers in Chrome's trace event format */
+	static bool writeChromeTrace(const std::string &path) {
+		FILE *file = std::fopen(path.c_str(), "w");
+		if (!file) return false;
+
+		std::lock_guard<std::mutex> lock(getMutex());
+		std::fprintf(file, "{\"traceEvents\":[\n");
+		bool first = true;
+		std::vector<TraceEvent> events;
+		for (TraceBuffer *buffer : getBuffers()) {
+			std::fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}", first ? "" : ",\n", buffer->tid, buffer->name);
+			first = false;
+			events.clear();
+			buffer->copy(events);
+			for (const TraceEvent &event : events) {
+				std::fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}", event.name, buffer->tid, event.start / 1000.0, event.duration / 1000.0);
+			}
+		}
+		std::fprintf(file, "\n]}\n");
+		std::fclose(file);
+		return true;
+	}
+};
+
+struct TraceZone {
+	const char *name;
+	int64_t start;
+
+	TraceZone(const char *name) : name(name), start(TraceBuffer::now()) {}
+	~TraceZone() { TraceBuffer::get()->push(name, start, TraceBuffer::now() - start); }
+};
+
+}  // namespace TheModularMind
@@ -119,6 +119,15 @@ public:
 	void Send( const char *data, std::size_t size );
     void SendTo( const IpEndpointName& remoteEndpoint, const char *data, std::size_t size );
 
+	// Send the same datagram to several remote endpoints. Uses a single
+	// sendmmsg() call where available (Linux), otherwise falls back to
+	// one sendto() per endpoint. An endpoint which fails doesn't keep the
+	// datagram from the following ones. Returns the number of datagrams sent,
+	// if results is given results[i] is set to 1 if the datagram was sent to
+	// remoteEndpoints[i], otherwise to 0.
+	std::size_t SendToMany( const IpEndpointName *remoteEndpoints, std::size_t count,
+			const char *data, std::size_t size, unsigned char *results = 0 );
+
 
 	// Bind a local endpoint to receive incoming data. Endpoint
 	// can be 'any' for the system to choose an endpoint
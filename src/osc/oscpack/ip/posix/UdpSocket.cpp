@@ -43,6 +43,7 @@
 #include <netdb.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <sys/time.h>
 #include <netinet/in.h> // for sockaddr_in
 
@@ -214,6 +215,63 @@ public:
         sendto( socket_, data, size, 0, (sockaddr*)&sendToAddr_, sizeof(sendToAddr_) );
 	}
 
+    std::size_t SendToMany( const IpEndpointName *remoteEndpoints, std::size_t count,
+			const char *data, std::size_t size, unsigned char *results )
+	{
+#if defined(__linux__)
+		static const std::size_t MAX_BATCH = 64;
+		struct sockaddr_in addrs[MAX_BATCH];
+		struct iovec iov;
+		struct mmsghdr msgs[MAX_BATCH];
+
+		iov.iov_base = (void*)data;
+		iov.iov_len = size;
+
+		std::size_t sent = 0;
+		for( std::size_t offset = 0; offset < count; offset += MAX_BATCH ){
+			std::size_t batch = std::min( count - offset, MAX_BATCH );
+			std::memset( msgs, 0, sizeof(msgs[0]) * batch );
+			for( std::size_t i = 0; i < batch; ++i ){
+				SockaddrFromIpEndpointName( addrs[i], remoteEndpoints[offset + i] );
+				msgs[i].msg_hdr.msg_name = &addrs[i];
+				msgs[i].msg_hdr.msg_namelen = sizeof(addrs[i]);
+				msgs[i].msg_hdr.msg_iov = &iov;
+				msgs[i].msg_hdr.msg_iovlen = 1;
+			}
+
+			// sendmmsg() stops at the first message which fails, the rest of the
+			// batch is sent with the next call
+			std::size_t done = 0;
+			while( done < batch ){
+				int result = sendmmsg( socket_, msgs + done, (unsigned int)(batch - done), 0 );
+				std::size_t ok = result > 0 ? (std::size_t)result : 0;
+				if( results )
+					std::memset( results + offset + done, 1, ok );
+				sent += ok;
+				done += ok;
+				if( done < batch ){
+					if( results )
+						results[offset + done] = 0;
+					++done;
+				}
+			}
+		}
+		return sent;
+#else
+		std::size_t sent = 0;
+		for( std::size_t i = 0; i < count; ++i ){
+			struct sockaddr_in addr;
+			SockaddrFromIpEndpointName( addr, remoteEndpoints[i] );
+			bool ok = sendto( socket_, data, size, 0, (sockaddr*)&addr, sizeof(addr) ) >= 0;
+			if( results )
+				results[i] = ok ? 1 : 0;
+			if( ok )
+				++sent;
+		}
+		return sent;
+#endif
+	}
+
 	void Bind( const IpEndpointName& localEndpoint )
 	{
 		struct sockaddr_in bindSockAddr;
@@ -289,6 +347,12 @@ void UdpSocket::SendTo( const IpEndpointName& remoteEndpoint, const char *data,
 	impl_->SendTo( remoteEndpoint, data, size );
 }
 
+std::size_t UdpSocket::SendToMany( const IpEndpointName *remoteEndpoints, std::size_t count,
+		const char *data, std::size_t size, unsigned char *results )
+{
+	return impl_->SendToMany( remoteEndpoints, count, data, size, results );
+}
+
 void UdpSocket::Bind( const IpEndpointName& localEndpoint )
 {
 	impl_->Bind( localEndpoint );
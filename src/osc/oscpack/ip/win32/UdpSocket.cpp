@@ -207,6 +207,22 @@ public:
         sendto( socket_, data, (int)size, 0, (sockaddr*)&sendToAddr_, sizeof(sendToAddr_) );
 	}
 
+    std::size_t SendToMany( const IpEndpointName *remoteEndpoints, std::size_t count,
+			const char *data, std::size_t size, unsigned char *results )
+	{
+		std::size_t sent = 0;
+		for( std::size_t i = 0; i < count; ++i ){
+			struct sockaddr_in addr;
+			SockaddrFromIpEndpointName( addr, remoteEndpoints[i] );
+			bool ok = sendto( socket_, data, (int)size, 0, (sockaddr*)&addr, sizeof(addr) ) != SOCKET_ERROR;
+			if( results )
+				results[i] = ok ? 1 : 0;
+			if( ok )
+				++sent;
+		}
+		return sent;
+	}
+
 	void Bind( const IpEndpointName& localEndpoint )
 	{
 		struct sockaddr_in bindSockAddr;
@@ -282,6 +298,12 @@ void UdpSocket::SendTo( const IpEndpointName& remoteEndpoint, const char *data,
 	impl_->SendTo( remoteEndpoint, data, size );
 }
 
+std::size_t UdpSocket::SendToMany( const IpEndpointName *remoteEndpoints, std::size_t count,
+		const char *data, std::size_t size, unsigned char *results )
+{
+	return impl_->SendToMany( remoteEndpoints, count, data, size, results );
+}
+
 void UdpSocket::Bind( const IpEndpointName& localEndpoint )
 {
 	impl_->Bind( localEndpoint );
@@ -6,4 +6,6 @@ void init(rack::Plugin* p) {
 	pluginInstance = p;
 	p->addModel(modelOSCelot);
 	p->addModel(modelOscelotExpander);
+	p->addModel(modelOscelotExpanderPoly);
+	p->addModel(modelOscelotCvExpander);
 }
\ No newline at end of file
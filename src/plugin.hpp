@@ -9,4 +9,6 @@ extern Plugin* pluginInstance;
 
 extern Model* modelOSCelot;
 extern Model* modelOscelotExpander;
+extern Model* modelOscelotExpanderPoly;
+extern Model* modelOscelotCvExpander;
 